@@ -0,0 +1,78 @@
+// cost of appending to account histories: ns && heap bytes per row, for accounts whose amount
+// index is never used && for accounts that run an amount query every queryEvery appends
+// usage: append_bench [accounts=10000] [rowsPerAccount=500] [queryEvery=64]
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <malloc.h>
+
+#include "Transactions.hpp"
+#include "bench.hpp"
+
+namespace
+{
+    // glibc heap currently handed out, in bytes
+    std::size_t heapInUse()
+    {
+        ::malloc_trim(0);
+        return ::mallinfo2().uordblks;
+    }
+
+    struct Result
+    {
+        double nanosecondsPerRow;
+        double bytesPerRow;
+    };
+
+    // rows land round robin across the accounts, like traffic spread over many customers
+    Result run(std::uint64_t accountCount, std::uint64_t rowsPerAccount, std::uint64_t queryEvery)
+    {
+        const std::size_t heapBefore = heapInUse();
+        std::vector<std::unique_ptr<TransactionLog>> logs;
+        logs.reserve(accountCount);
+        for (std::uint64_t i = 0; i < accountCount; ++i)
+        {
+            logs.push_back(std::make_unique<TransactionLog>());
+        }
+
+        bench::Random random(11);
+        std::int64_t timeStamp = 1'700'000'000;
+        std::size_t found = 0;
+        const auto start = bench::Clock::now();
+        for (std::uint64_t row = 0; row < rowsPerAccount; ++row)
+        {
+            for (std::uint64_t account = 0; account < accountCount; ++account)
+            {
+                const auto type = (random.below(3) == 0) ? TransactionType::Withdrawal : TransactionType::Deposit;
+                logs[account]->append(type, Money::fromCents(static_cast<std::int64_t>(random.below(100'000))), timeStamp);
+                if (queryEvery != 0 && (row + 1) % queryEvery == 0)
+                {
+                    found += logs[account]->largest(TransactionType::Withdrawal, 10).size();
+                }
+            }
+            ++timeStamp;
+        }
+        const double nanoseconds = bench::nanosecondsSince(start, accountCount * rowsPerAccount);
+        bench::doNotOptimize(found);
+
+        const double bytes = static_cast<double>(heapInUse() - heapBefore) / static_cast<double>(accountCount * rowsPerAccount);
+        return Result{nanoseconds, bytes};
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t accountCount = bench::argOr(argc, argv, 1, 10'000);
+    const std::uint64_t rowsPerAccount = bench::argOr(argc, argv, 2, 500);
+    const std::uint64_t queryEvery = bench::argOr(argc, argv, 3, 64);
+
+    std::printf("%llu accounts x %llu rows\n", static_cast<unsigned long long>(accountCount), static_cast<unsigned long long>(rowsPerAccount));
+    std::printf("%-22s %10s %10s\n", "", "ns/row", "heap B/row");
+    const Result plain = run(accountCount, rowsPerAccount, 0);
+    std::printf("%-22s %10.1f %10.1f\n", "append only", plain.nanosecondsPerRow, plain.bytesPerRow);
+    const Result queried = run(accountCount, rowsPerAccount, queryEvery);
+    char label[32];
+    std::snprintf(label, sizeof(label), "query every %llu", static_cast<unsigned long long>(queryEvery));
+    std::printf("%-22s %10.1f %10.1f\n", label, queried.nanosecondsPerRow, queried.bytesPerRow);
+    return 0;
+}
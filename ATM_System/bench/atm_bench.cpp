@@ -0,0 +1,169 @@
+// regression suite: authenticate, deposite, withdraw, history rendering && sorting
+// at several account / history sizes, every operation timed individually
+// writes one JSON document to stdout (throughput + p50/p99/p999), a readable table to stderr
+// usage: atm_bench [maxAccounts=1000000] [maxHistory=100000] > results.json
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <functional>
+
+#include "ATM.hpp"
+#include "bench.hpp"
+#include "histogram.hpp"
+
+namespace
+{
+    struct CaseResult
+    {
+        std::string name;
+        const char * parameter;
+        std::uint64_t size;
+        double opsPerSecond;
+        bench::LatencyHistogram latency;
+    };
+
+    // runs operation(i) iterations times, one clock read per operation boundary
+    CaseResult measure(std::string name, const char * parameter, std::uint64_t size, std::uint64_t iterations, const std::function<void(std::uint64_t)> & operation)
+    {
+        CaseResult result{std::move(name), parameter, size, 0, {}};
+        const auto start = bench::Clock::now();
+        auto previous = start;
+        for (std::uint64_t i = 0; i < iterations; ++i)
+        {
+            operation(i);
+            const auto now = bench::Clock::now();
+            result.latency.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - previous).count()));
+            previous = now;
+        }
+        const double seconds = std::chrono::duration<double>(previous - start).count();
+        result.opsPerSecond = static_cast<double>(iterations) / seconds;
+        return result;
+    }
+
+    // one account with historySize alternating deposits && withdrawals already applied
+    void fillHistory(Account & account, std::uint64_t historySize)
+    {
+        std::vector<Operation> history;
+        history.reserve(historySize);
+        bench::Random random(historySize);
+        for (std::uint64_t i = 0; i < historySize; ++i)
+        {
+            const auto type = (i & 1) ? TransactionType::Withdrawal : TransactionType::Deposit;
+            history.push_back(Operation{type, Money::fromCents(static_cast<std::int64_t>(1 + random.below(100'000)))});
+        }
+        account.applyBatch(history);
+    }
+
+    void printJson(const std::vector<CaseResult> & results)
+    {
+        std::printf("{\n  \"unit\": \"ns\",\n  \"benchmarks\": [\n");
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const CaseResult & result = results[i];
+            const bench::LatencyHistogram & latency = result.latency;
+            std::printf("    {\"name\": \"%s\", \"%s\": %llu, \"operations\": %llu, \"opsPerSecond\": %.1f, "
+                        "\"min\": %llu, \"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}%s\n",
+                        result.name.c_str(), result.parameter, static_cast<unsigned long long>(result.size),
+                        static_cast<unsigned long long>(latency.count()), result.opsPerSecond,
+                        static_cast<unsigned long long>(latency.min()), static_cast<unsigned long long>(latency.percentile(0.50)),
+                        static_cast<unsigned long long>(latency.percentile(0.99)), static_cast<unsigned long long>(latency.percentile(0.999)),
+                        static_cast<unsigned long long>(latency.max()), (i + 1 < results.size()) ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    }
+
+    void printTable(const std::vector<CaseResult> & results)
+    {
+        std::fprintf(stderr, "%-16s %10s %14s %8s %8s %8s\n", "case", "size", "ops/s", "p50", "p99", "p999");
+        for (const CaseResult & result : results)
+        {
+            std::fprintf(stderr, "%-16s %10llu %14.0f %8llu %8llu %8llu\n", result.name.c_str(),
+                         static_cast<unsigned long long>(result.size), result.opsPerSecond,
+                         static_cast<unsigned long long>(result.latency.percentile(0.50)),
+                         static_cast<unsigned long long>(result.latency.percentile(0.99)),
+                         static_cast<unsigned long long>(result.latency.percentile(0.999)));
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t maxAccounts = bench::argOr(argc, argv, 1, 1'000'000);
+    const std::uint64_t maxHistory = bench::argOr(argc, argv, 2, 100'000);
+    constexpr std::uint64_t operations = 200'000;
+
+    std::vector<CaseResult> results;
+    bench::MuteCout mute;
+
+    for (std::uint64_t accountCount = 1'000; accountCount <= maxAccounts; accountCount *= 10)
+    {
+        ATM atm;
+        atm.reserve(accountCount);
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            atm.addAccount(bench::accountNumber(id), static_cast<int>(id % 10'000), Money::fromUnits(100));
+        }
+
+        bench::Random random(accountCount);
+        std::vector<std::string> keys;
+        std::vector<int> pins;
+        keys.reserve(operations);
+        pins.reserve(operations);
+        for (std::uint64_t i = 0; i < operations; ++i)
+        {
+            const std::uint64_t id = random.below(accountCount);
+            keys.push_back(bench::accountNumber(id));
+            pins.push_back(static_cast<int>(id % 10'000));
+        }
+
+        results.push_back(measure("authenticate", "accounts", accountCount, operations, [&](std::uint64_t i)
+        {
+            bench::doNotOptimize(atm.authenticate(keys[i], pins[i]));
+        }));
+    }
+
+    for (std::uint64_t historySize = 1'000; historySize <= maxHistory; historySize *= 10)
+    {
+        {
+            Account account("deposite", 0, Money::fromUnits(1'000'000'000));
+            fillHistory(account, historySize);
+            results.push_back(measure("deposite", "history", historySize, operations, [&](std::uint64_t)
+            {
+                account.deposite(Money::fromCents(1'234));
+            }));
+        }
+
+        {
+            Account account("withdraw", 0, Money::fromUnits(1'000'000'000));
+            fillHistory(account, historySize);
+            results.push_back(measure("withdraw", "history", historySize, operations, [&](std::uint64_t)
+            {
+                account.withdraw(Money::fromCents(1'234));
+            }));
+        }
+
+        Account account("history", 0, Money::fromUnits(1'000'000'000));
+        fillHistory(account, historySize);
+
+        // one default-sized page per operation, walking the whole history
+        HistoryRenderer renderer;
+        PageRequest request;
+        results.push_back(measure("renderPage", "history", historySize, 20'000, [&](std::uint64_t)
+        {
+            const HistoryPage page = account.renderHistory(renderer, request);
+            request.offset = page.hasMore() ? page.nextOffset : 0;
+            bench::doNotOptimize(renderer.view().data());
+            renderer.clear();
+        }));
+
+        const std::uint64_t sorts = std::max<std::uint64_t>(20, 10'000'000 / historySize);
+        results.push_back(measure("sortByAmount", "history", historySize, sorts, [&](std::uint64_t)
+        {
+            account.sortTransactionsByAmount();
+        }));
+    }
+
+    printJson(results);
+    printTable(results);
+    return 0;
+}
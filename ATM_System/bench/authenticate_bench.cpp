@@ -0,0 +1,52 @@
+// login latency vs number of registered accounts
+// usage: authenticate_bench [maxAccounts=10000000] [lookups=1000000]
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include "ATM.hpp"
+#include "bench.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t maxAccounts = bench::argOr(argc, argv, 1, 10'000'000);
+    const std::uint64_t lookups = bench::argOr(argc, argv, 2, 1'000'000);
+
+    std::printf("%12s %14s\n", "accounts", "ns/authenticate");
+
+    for (std::uint64_t accountCount = 1'000; accountCount <= maxAccounts; accountCount *= 10)
+    {
+        ATM atm;
+        atm.reserve(accountCount);
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            atm.addAccount(bench::accountNumber(id), static_cast<int>(id % 10'000), Money::fromUnits(100));
+        }
+
+        // pre-generate keys so string building stays out of the timed loop
+        bench::Random random(accountCount);
+        std::vector<std::string> keys;
+        std::vector<int> pins;
+        keys.reserve(lookups);
+        pins.reserve(lookups);
+        for (std::uint64_t i = 0; i < lookups; ++i)
+        {
+            const std::uint64_t id = random.below(accountCount);
+            keys.push_back(bench::accountNumber(id));
+            pins.push_back(static_cast<int>(id % 10'000));
+        }
+
+        bench::MuteCout mute;
+        const auto start = bench::Clock::now();
+        for (std::uint64_t i = 0; i < lookups; ++i)
+        {
+            auto account = atm.authenticate(keys[i], pins[i]);
+            bench::doNotOptimize(account);
+        }
+        const double ns = bench::nanosecondsSince(start, lookups);
+
+        std::printf("%12llu %14.1f\n", static_cast<unsigned long long>(accountCount), ns);
+    }
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+// applyBatch vs one deposite/withdraw call per operation
+// usage: batch_bench [batchSize=4096] [rounds=200]
+#include <vector>
+#include <cstdio>
+
+#include "Account.hpp"
+#include "bench.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t batchSize = bench::argOr(argc, argv, 1, 4'096);
+    const std::uint64_t rounds = bench::argOr(argc, argv, 2, 200);
+
+    std::vector<Operation> batch;
+    batch.reserve(batchSize);
+    bench::Random random(42);
+    for (std::uint64_t i = 0; i < batchSize; ++i)
+    {
+        const auto type = (i & 1) ? TransactionType::Withdrawal : TransactionType::Deposit;
+        batch.push_back(Operation{type, Money::fromCents(static_cast<std::int64_t>(1 + random.below(10'000)))});
+    }
+
+    double singleNs = 0;
+    {
+        bench::MuteCout mute;
+        const auto start = bench::Clock::now();
+        for (std::uint64_t round = 0; round < rounds; ++round)
+        {
+            Account account("single", 0, Money::fromUnits(1'000'000));
+            for (const auto & operation : batch)
+            {
+                if (operation.type == TransactionType::Deposit)
+                {
+                    account.deposite(operation.amount);
+                }
+                else
+                {
+                    account.withdraw(operation.amount);
+                }
+            }
+        }
+        singleNs = bench::nanosecondsSince(start, batchSize * rounds);
+    }
+
+    const auto start = bench::Clock::now();
+    for (std::uint64_t round = 0; round < rounds; ++round)
+    {
+        Account account("batched", 0, Money::fromUnits(1'000'000));
+        auto results = account.applyBatch(batch);
+        bench::doNotOptimize(results.data());
+    }
+    const double batchNs = bench::nanosecondsSince(start, batchSize * rounds);
+
+    std::printf("%-12s %12s\n", "path", "ns/op");
+    std::printf("%-12s %12.1f\n", "one-by-one", singleNs);
+    std::printf("%-12s %12.1f\n", "applyBatch", batchNs);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <iostream> // in/out stream
+#include <chrono> // steady clock timing
+#include <cstdint> // fixed width integers
+#include <cstdlib> // strtoull
+#include <string> // account number generation
+
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Account/ATM report every operation on std::cout, mute it while measuring
+    class MuteCout
+    {
+        private:
+            std::streambuf * saved;
+
+        public:
+            MuteCout() : saved(std::cout.rdbuf(nullptr)) {}
+            ~MuteCout()
+            {
+                std::cout.rdbuf(saved);
+                std::cout.clear();
+            }
+    };
+
+    template <typename T>
+    inline void doNotOptimize(const T & value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    inline double nanosecondsSince(Clock::time_point start, std::uint64_t operations)
+    {
+        const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+        return elapsed.count() / static_cast<double>(operations);
+    }
+
+    inline std::string accountNumber(std::uint64_t id)
+    {
+        return "ACC" + std::to_string(id);
+    }
+
+    // xorshift64*: cheap enough not to show up in the measurements
+    class Random
+    {
+        private:
+            std::uint64_t state;
+
+        public:
+            explicit Random(std::uint64_t seed) : state(seed | 1) {}
+
+            std::uint64_t next()
+            {
+                state ^= state >> 12;
+                state ^= state << 25;
+                state ^= state >> 27;
+                return state * 2685821657736338717ULL;
+            }
+
+            std::uint64_t below(std::uint64_t bound)
+            {
+                return next() % bound;
+            }
+    };
+
+    inline std::uint64_t argOr(int argc, char ** argv, int position, std::uint64_t fallback)
+    {
+        return (argc > position) ? std::strtoull(argv[position], nullptr, 10) : fallback;
+    }
+}
@@ -0,0 +1,134 @@
+// bounded account cache over an on-disk store: hit rate, evictions && per-access latency
+// for Zipfian (skewed) account popularity at several cache sizes
+// usage: cache_bench [accounts=100000] [accesses=1000000] [zipfTheta(x100)=99] [path=/tmp/atm_cache_bench.store]
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+#include "AccountCache.hpp"
+#include "bench.hpp"
+#include "histogram.hpp"
+
+namespace
+{
+    // rank r (0 = most popular) with probability ~ 1 / (r + 1)^theta, by binary search over the CDF
+    class ZipfGenerator
+    {
+        private:
+            std::vector<double> cumulative;
+            bench::Random random;
+
+        public:
+            ZipfGenerator(std::size_t count, double theta, std::uint64_t seed) : cumulative(count), random(seed)
+            {
+                double sum = 0;
+                for (std::size_t rank = 0; rank < count; ++rank)
+                {
+                    sum += 1.0 / std::pow(static_cast<double>(rank + 1), theta);
+                    cumulative[rank] = sum;
+                }
+                for (double & value : cumulative)
+                {
+                    value /= sum;
+                }
+            }
+
+            std::size_t next()
+            {
+                const double u = static_cast<double>(random.next() >> 11) * 0x1.0p-53;
+                return static_cast<std::size_t>(std::lower_bound(cumulative.begin(), cumulative.end() - 1, u) - cumulative.begin());
+            }
+    };
+}
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t accountCount = bench::argOr(argc, argv, 1, 100'000);
+    const std::uint64_t accesses = bench::argOr(argc, argv, 2, 1'000'000);
+    const double theta = static_cast<double>(bench::argOr(argc, argv, 3, 99)) / 100.0;
+    const std::string path = (argc > 4) ? argv[4] : "/tmp/atm_cache_bench.store";
+
+    // popularity ranks are scattered over the id space, so hot accounts aren't neighbours on disk
+    std::vector<std::string> byRank(accountCount);
+    for (std::uint64_t rank = 0; rank < accountCount; ++rank)
+    {
+        byRank[rank] = bench::accountNumber((rank * 0x9E3779B97F4A7C15ULL) % accountCount);
+    }
+
+    std::printf("%llu accounts, %llu accesses, zipf theta %.2f, 20%% writes\n",
+                static_cast<unsigned long long>(accountCount), static_cast<unsigned long long>(accesses), theta);
+    std::printf("%-9s %9s %10s %11s %9s %9s %9s\n", "capacity", "hit rate", "evictions", "writebacks", "mean ns", "p50 ns", "p99 ns");
+
+    for (const double fraction : {0.01, 0.05, 0.10, 0.25})
+    {
+        ::unlink(path.c_str());
+        AccountStore store(path);
+        bench::Random random(17);
+        std::int64_t openingCents = 0;
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            Account account(bench::accountNumber(id), 1234, Money::fromUnits(1'000));
+            std::int64_t timeStamp = 1'700'000'000;
+            for (std::uint64_t i = 0; i < 16; ++i)
+            {
+                timeStamp += static_cast<std::int64_t>(random.below(86'400));
+                account.restore(TransactionType::Deposit, Money::fromCents(static_cast<std::int64_t>(1 + random.below(40'000))), timeStamp);
+            }
+            openingCents += account.getBalance().getCents();
+            store.add(account);
+        }
+
+        std::int64_t expectedCents = 0;
+        bench::LatencyHistogram latency;
+        const auto capacity = static_cast<std::size_t>(static_cast<double>(accountCount) * fraction);
+        CacheStats stats;
+        double meanNanoseconds;
+        {
+            AccountCache cache(store, capacity);
+            ZipfGenerator popularity(accountCount, theta, 23);
+            const Operation deposit{TransactionType::Deposit, Money::fromCents(100)};
+            const auto start = bench::Clock::now();
+            for (std::uint64_t i = 0; i < accesses; ++i)
+            {
+                const std::string & accountNumber = byRank[popularity.next()];
+                const bool isWrite = random.below(5) == 0;
+                const auto accessStart = bench::Clock::now();
+                AccountLease lease = cache.acquire(accountNumber, isWrite ? AccessMode::Write : AccessMode::Read);
+                if (isWrite)
+                {
+                    lease->applyBatch(std::span<const Operation>(&deposit, 1));
+                    expectedCents += 100;
+                }
+                else
+                {
+                    bench::doNotOptimize(lease->getBalance());
+                }
+                lease.release();
+                latency.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(bench::Clock::now() - accessStart).count()));
+            }
+            meanNanoseconds = bench::nanosecondsSince(start, accesses);
+            stats = cache.stats();
+        }
+
+        // everything written back: the deposits must all be in the store
+        std::int64_t totalCents = 0;
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            totalCents += store.load(bench::accountNumber(id))->getBalance().getCents();
+        }
+        if (totalCents - openingCents != expectedCents)
+        {
+            std::fprintf(stderr, "cache_bench: %lld cents deposited, %lld found in the store\n",
+                         static_cast<long long>(expectedCents), static_cast<long long>(totalCents - openingCents));
+            return 1;
+        }
+
+        std::printf("%-9zu %8.1f%% %10llu %11llu %9.0f %9llu %9llu\n", capacity, stats.hitRate() * 100.0,
+                    static_cast<unsigned long long>(stats.evictions), static_cast<unsigned long long>(stats.writeBacks), meanNanoseconds,
+                    static_cast<unsigned long long>(latency.percentile(0.50)), static_cast<unsigned long long>(latency.percentile(0.99)));
+    }
+    ::unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,82 @@
+// encode / decode throughput of the binary transaction format (TransactionCodec.hpp)
+// GB/s is counted over the in-memory Transaction records (24 bytes each) && over the encoded bytes
+// usage: codec_bench [records=5000000] [rounds=5]
+#include <vector>
+#include <cstdio>
+
+#include "TransactionCodec.hpp"
+#include "bench.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t recordCount = bench::argOr(argc, argv, 1, 5'000'000);
+    const std::uint64_t rounds = bench::argOr(argc, argv, 2, 5);
+
+    // ATM-like traffic: mostly small amounts, seconds-to-hours between transactions
+    bench::Random random(7);
+    std::vector<Transaction> records;
+    records.reserve(recordCount);
+    std::int64_t timeStamp = 1'700'000'000;
+    std::int64_t checksum = 0;
+    for (std::uint64_t i = 0; i < recordCount; ++i)
+    {
+        const auto type = static_cast<TransactionType>(random.below(transactionTypeCount));
+        const auto cents = static_cast<std::int64_t>((random.below(8) == 0) ? random.below(100'000'000) : random.below(50'000));
+        timeStamp += static_cast<std::int64_t>(random.below(3'600));
+        records.push_back(Transaction{type, Money::fromCents(cents), timeStamp});
+        checksum += cents ^ timeStamp;
+    }
+
+    TransactionWriter writer;
+    double bestEncode = 1e300;
+    for (std::uint64_t round = 0; round < rounds; ++round)
+    {
+        writer.clear();
+        const auto start = bench::Clock::now();
+        for (const Transaction & transaction : records)
+        {
+            writer.append(transaction);
+        }
+        bench::doNotOptimize(writer.bytes().data());
+        bestEncode = std::min(bestEncode, bench::nanosecondsSince(start, recordCount));
+    }
+
+    const auto reader = TransactionReader::open(writer.bytes());
+    if (!reader)
+    {
+        std::fprintf(stderr, "codec_bench: encoded stream has a bad header\n");
+        return 1;
+    }
+
+    double bestDecode = 1e300;
+    std::uint64_t decoded = 0;
+    std::int64_t decodedChecksum = 0;
+    for (std::uint64_t round = 0; round < rounds; ++round)
+    {
+        decoded = 0;
+        decodedChecksum = 0;
+        const auto start = bench::Clock::now();
+        for (const Transaction & transaction : *reader)
+        {
+            decodedChecksum += transaction.amount.getCents() ^ transaction.timeStamp;
+            ++decoded;
+        }
+        bench::doNotOptimize(decodedChecksum);
+        bestDecode = std::min(bestDecode, bench::nanosecondsSince(start, recordCount));
+    }
+
+    if (decoded != recordCount || decodedChecksum != checksum || reader->isCorrupt())
+    {
+        std::fprintf(stderr, "codec_bench: round trip mismatch (%llu of %llu records)\n",
+                     static_cast<unsigned long long>(decoded), static_cast<unsigned long long>(recordCount));
+        return 1;
+    }
+
+    const double encodedPerRecord = static_cast<double>(writer.size()) / static_cast<double>(recordCount);
+    std::printf("%llu records, %.2f bytes/record encoded vs %zu in memory (%.1fx smaller)\n",
+                static_cast<unsigned long long>(recordCount), encodedPerRecord, sizeof(Transaction), sizeof(Transaction) / encodedPerRecord);
+    std::printf("%-8s %10s %14s %14s\n", "", "ns/record", "GB/s records", "GB/s encoded");
+    std::printf("%-8s %10.2f %14.2f %14.2f\n", "encode", bestEncode, sizeof(Transaction) / bestEncode, encodedPerRecord / bestEncode);
+    std::printf("%-8s %10.2f %14.2f %14.2f\n", "decode", bestDecode, sizeof(Transaction) / bestDecode, encodedPerRecord / bestDecode);
+    return 0;
+}
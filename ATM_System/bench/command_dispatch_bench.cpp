@@ -0,0 +1,107 @@
+// compile-time perfect-hash dispatch vs the string if-chain it replaced
+// usage: command_dispatch_bench [lines=1000000] [rounds=20]
+#include <array>
+#include <vector>
+#include <cstdio>
+#include <string_view>
+
+#include "CommandTable.hpp"
+#include "bench.hpp"
+
+namespace
+{
+    struct Counters
+    {
+        std::int64_t deposited = 0;
+        std::int64_t withdrawn = 0;
+        std::uint64_t queries = 0;
+    };
+
+    constexpr CommandTable<Counters, 5> commands({{
+        {"deposite", ArgumentKind::Amount, [](Counters & counters, const ParsedArguments & arguments) { counters.deposited += arguments.amount.getCents(); }},
+        {"withdraw", ArgumentKind::Amount, [](Counters & counters, const ParsedArguments & arguments) { counters.withdrawn += arguments.amount.getCents(); }},
+        {"balance",  ArgumentKind::None,   [](Counters & counters, const ParsedArguments &) { ++counters.queries; }},
+        {"history",  ArgumentKind::None,   [](Counters & counters, const ParsedArguments &) { ++counters.queries; }},
+        {"sort",     ArgumentKind::None,   [](Counters & counters, const ParsedArguments &) { ++counters.queries; }},
+    }});
+
+    // the original shape: split off the action, then compare it against each name in turn
+    bool ifChain(Counters & counters, std::string_view line)
+    {
+        const std::size_t space = line.find(' ');
+        const std::string_view action = line.substr(0, space);
+        const std::string_view rest = (space == std::string_view::npos) ? std::string_view{} : line.substr(space + 1);
+
+        if (action == "deposite")
+        {
+            const auto amount = Money::parse(rest);
+            counters.deposited += amount ? amount->getCents() : 0;
+        }
+        else if (action == "withdraw")
+        {
+            const auto amount = Money::parse(rest);
+            counters.withdrawn += amount ? amount->getCents() : 0;
+        }
+        else if (action == "balance" || action == "history" || action == "sort")
+        {
+            ++counters.queries;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t lineCount = bench::argOr(argc, argv, 1, 1'000'000);
+    const std::uint64_t rounds = bench::argOr(argc, argv, 2, 20);
+
+    // realistic mix: mostly balance checks && withdrawals, a few typos
+    static constexpr std::array<std::string_view, 10> mix = {
+        "balance", "balance", "balance", "withdraw 60", "withdraw 120.50",
+        "deposite 500", "history", "sort", "balanse", "withdraw 20",
+    };
+    std::vector<std::string_view> lines;
+    lines.reserve(lineCount);
+    bench::Random random(7);
+    for (std::uint64_t i = 0; i < lineCount; ++i)
+    {
+        lines.push_back(mix[random.below(mix.size())]);
+    }
+
+    Counters chainCounters;
+    auto start = bench::Clock::now();
+    for (std::uint64_t round = 0; round < rounds; ++round)
+    {
+        for (const std::string_view line : lines)
+        {
+            bench::doNotOptimize(ifChain(chainCounters, line));
+        }
+    }
+    const double chainNs = bench::nanosecondsSince(start, lineCount * rounds);
+
+    Counters tableCounters;
+    start = bench::Clock::now();
+    for (std::uint64_t round = 0; round < rounds; ++round)
+    {
+        for (const std::string_view line : lines)
+        {
+            bench::doNotOptimize(commands.dispatch(tableCounters, line));
+        }
+    }
+    const double tableNs = bench::nanosecondsSince(start, lineCount * rounds);
+
+    if (chainCounters.deposited != tableCounters.deposited || chainCounters.withdrawn != tableCounters.withdrawn || chainCounters.queries != tableCounters.queries)
+    {
+        std::printf("mismatch between dispatch paths!\n");
+        return 1;
+    }
+
+    std::printf("%-12s %12s\n", "path", "ns/command");
+    std::printf("%-12s %12.1f\n", "if-chain", chainNs);
+    std::printf("%-12s %12.1f\n", "hash table", tableNs);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// deposit/withdraw throughput on random accounts, 1 -> 64 threads
+// usage: concurrency_bench [accounts=100000] [opsPerThread=200000]
+#include <vector>
+#include <thread>
+#include <cstdio>
+
+#include "ATM.hpp"
+#include "bench.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t accountCount = bench::argOr(argc, argv, 1, 100'000);
+    const std::uint64_t opsPerThread = bench::argOr(argc, argv, 2, 200'000);
+
+    ATM atm;
+    atm.reserve(accountCount);
+    std::vector<AccountHandle> handles;
+    handles.reserve(accountCount);
+    for (std::uint64_t id = 0; id < accountCount; ++id)
+    {
+        atm.addAccount(bench::accountNumber(id), 1234, Money::fromUnits(1'000'000));
+    }
+
+    bench::MuteCout mute;
+    for (std::uint64_t id = 0; id < accountCount; ++id)
+    {
+        handles.push_back(atm.authenticate(bench::accountNumber(id), 1234));
+    }
+
+    std::printf("%8s %16s\n", "threads", "Mops/s");
+
+    for (unsigned threadCount = 1; threadCount <= 64; threadCount *= 2)
+    {
+        std::vector<std::thread> workers;
+        const auto start = bench::Clock::now();
+        for (unsigned t = 0; t < threadCount; ++t)
+        {
+            workers.emplace_back([&, t]
+            {
+                bench::Random random(t + 1);
+                for (std::uint64_t i = 0; i < opsPerThread; ++i)
+                {
+                    const AccountLease lease = atm.acquire(handles[random.below(accountCount)]);
+                    Account & account = *lease;
+                    if (i & 1)
+                    {
+                        account.withdraw(Money::fromUnits(1));
+                    }
+                    else
+                    {
+                        account.deposite(Money::fromUnits(1));
+                    }
+                }
+            });
+        }
+        for (auto & worker : workers)
+        {
+            worker.join();
+        }
+
+        const double ns = bench::nanosecondsSince(start, opsPerThread * threadCount);
+        std::printf("%8u %16.2f\n", threadCount, 1'000.0 / ns);
+    }
+
+    return 0;
+}
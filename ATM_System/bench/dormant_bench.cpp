@@ -0,0 +1,117 @@
+// dormant tier: heap held by account histories before && after compressDormant,
+// && what the first access to a compressed account costs compared to a resident one
+// usage: dormant_bench [accounts=20000] [historyPerAccount=500]
+#include <vector>
+#include <cstdio>
+#include <malloc.h>
+
+#include "ATM.hpp"
+#include "bench.hpp"
+#include "histogram.hpp"
+
+namespace
+{
+    // glibc heap currently handed out, in bytes
+    std::size_t heapInUse()
+    {
+        ::malloc_trim(0);
+        return ::mallinfo2().uordblks;
+    }
+
+    std::int64_t checksum(const HistorySnapshot & history)
+    {
+        std::int64_t sum = history.getBalance().getCents();
+        for (std::size_t i = 0; i < history.size(); ++i)
+        {
+            sum += (history[i].amount.getCents() * 31 + history[i].timeStamp) ^ static_cast<std::int64_t>(history[i].type);
+        }
+        return sum;
+    }
+
+    // snapshot() latency per account, in random order
+    bench::LatencyHistogram timeFirstReads(const std::vector<Account *> & accounts, std::uint64_t seed, std::int64_t & sum)
+    {
+        std::vector<Account *> order = accounts;
+        bench::Random random(seed);
+        for (std::size_t i = order.size(); i > 1; --i)
+        {
+            std::swap(order[i - 1], order[random.below(i)]);
+        }
+
+        bench::LatencyHistogram latency;
+        sum = 0;
+        for (Account * account : order)
+        {
+            const auto start = bench::Clock::now();
+            const HistorySnapshot history = account->snapshot();
+            latency.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(bench::Clock::now() - start).count()));
+            sum += checksum(history);
+        }
+        return latency;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t accountCount = bench::argOr(argc, argv, 1, 20'000);
+    const std::uint64_t historySize = bench::argOr(argc, argv, 2, 500);
+
+    ATM atm;
+    atm.reserve(accountCount);
+    std::vector<AccountLease> leases; // held for the whole run
+    std::vector<Account *> accounts;
+    {
+        bench::MuteCout mute;
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            atm.addAccount(bench::accountNumber(id), 1234, Money::fromUnits(1'000));
+            leases.push_back(atm.acquire(atm.tryAuthenticate(bench::accountNumber(id), 1234)));
+            accounts.push_back(leases.back().get());
+        }
+    }
+
+    const std::size_t emptyHeap = heapInUse();
+    bench::Random random(11);
+    for (Account * account : accounts)
+    {
+        std::int64_t timeStamp = 1'700'000'000;
+        for (std::uint64_t i = 0; i < historySize; ++i)
+        {
+            timeStamp += static_cast<std::int64_t>(random.below(86'400));
+            const auto type = random.below(3) == 0 ? TransactionType::Withdrawal : TransactionType::Deposit;
+            account->restore(type, Money::fromCents(static_cast<std::int64_t>(1 + random.below(40'000))), timeStamp);
+        }
+    }
+
+    std::int64_t residentSum;
+    const bench::LatencyHistogram resident = timeFirstReads(accounts, 3, residentSum);
+    const std::size_t residentHeap = heapInUse() - emptyHeap;
+
+    const auto start = bench::Clock::now();
+    const std::size_t compressed = atm.compressDormant(0);
+    const double sweepNanoseconds = bench::nanosecondsSince(start, 1);
+    const std::size_t dormantHeap = heapInUse() - emptyHeap;
+
+    std::int64_t dormantSum;
+    const bench::LatencyHistogram woken = timeFirstReads(accounts, 5, dormantSum);
+    if (compressed != accountCount || dormantSum != residentSum)
+    {
+        std::fprintf(stderr, "dormant_bench: %zu of %llu accounts compressed, checksum %s\n",
+                     compressed, static_cast<unsigned long long>(accountCount), dormantSum == residentSum ? "ok" : "MISMATCH");
+        return 1;
+    }
+
+    const double rows = static_cast<double>(accountCount * historySize);
+    std::printf("%llu accounts x %llu transactions, sweep took %.1f ms\n",
+                static_cast<unsigned long long>(accountCount), static_cast<unsigned long long>(historySize), sweepNanoseconds / 1e6);
+    std::printf("%-10s %12s %10s\n", "histories", "heap MiB", "B/row");
+    std::printf("%-10s %12.1f %10.1f\n", "resident", static_cast<double>(residentHeap) / (1 << 20), static_cast<double>(residentHeap) / rows);
+    std::printf("%-10s %12.1f %10.1f   (%.1fx less)\n", "dormant", static_cast<double>(dormantHeap) / (1 << 20), static_cast<double>(dormantHeap) / rows,
+                static_cast<double>(residentHeap) / static_cast<double>(dormantHeap));
+    std::printf("%-10s %10s %10s %10s\n", "snapshot()", "p50 ns", "p99 ns", "max ns");
+    std::printf("%-10s %10llu %10llu %10llu\n", "resident", static_cast<unsigned long long>(resident.percentile(0.50)),
+                static_cast<unsigned long long>(resident.percentile(0.99)), static_cast<unsigned long long>(resident.max()));
+    std::printf("%-10s %10llu %10llu %10llu\n", "dormant", static_cast<unsigned long long>(woken.percentile(0.50)),
+                static_cast<unsigned long long>(woken.percentile(0.99)), static_cast<unsigned long long>(woken.max()));
+    return 0;
+}
@@ -0,0 +1,75 @@
+// credential-stuffing mix: authenticate with a growing share of nonexistent account numbers
+// plus the filter on its own (probe cost && measured false-positive rate)
+// usage: filter_bench [accounts=1000000] [lookups=1000000]
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include "ATM.hpp"
+#include "AccountFilter.hpp"
+#include "bench.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t accountCount = bench::argOr(argc, argv, 1, 1'000'000);
+    const std::uint64_t lookups = bench::argOr(argc, argv, 2, 1'000'000);
+
+    ATM atm;
+    {
+        bench::MuteCout mute;
+        atm.reserve(accountCount);
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            atm.addAccount(bench::accountNumber(id), static_cast<int>(id % 10'000), Money::fromUnits(100));
+        }
+    }
+
+    std::printf("%10s %16s\n", "invalid %", "ns/authenticate");
+    for (const std::uint64_t invalidPercent : {0, 50, 90, 99, 100})
+    {
+        bench::Random random(invalidPercent + 1);
+        std::vector<std::string> keys;
+        std::vector<int> pins;
+        keys.reserve(lookups);
+        pins.reserve(lookups);
+        for (std::uint64_t i = 0; i < lookups; ++i)
+        {
+            const std::uint64_t id = random.below(accountCount);
+            const bool isInvalid = random.below(100) < invalidPercent;
+            keys.push_back(isInvalid ? "ACX" + std::to_string(id) : bench::accountNumber(id));
+            pins.push_back(static_cast<int>(id % 10'000));
+        }
+
+        const auto start = bench::Clock::now();
+        for (std::uint64_t i = 0; i < lookups; ++i)
+        {
+            bench::doNotOptimize(atm.tryAuthenticate(keys[i], pins[i]));
+        }
+        std::printf("%10llu %16.1f\n", static_cast<unsigned long long>(invalidPercent), bench::nanosecondsSince(start, lookups));
+    }
+
+    // the filter alone, sized like the ATM's
+    AccountFilter filter(accountCount);
+    for (std::uint64_t id = 0; id < accountCount; ++id)
+    {
+        filter.insert(hashAccountNumber(bench::accountNumber(id)));
+    }
+    std::vector<std::uint64_t> absentHashes;
+    absentHashes.reserve(lookups);
+    for (std::uint64_t i = 0; i < lookups; ++i)
+    {
+        absentHashes.push_back(hashAccountNumber("ACX" + std::to_string(i)));
+    }
+
+    std::uint64_t falsePositives = 0;
+    const auto start = bench::Clock::now();
+    for (const std::uint64_t hash : absentHashes)
+    {
+        falsePositives += filter.mayContain(hash) ? 1 : 0;
+    }
+    const double probeNs = bench::nanosecondsSince(start, lookups);
+
+    std::printf("\nfilter: %.1f ns/probe, %.3f%% false positives, %zu keys capacity\n",
+                probeNs, 100.0 * static_cast<double>(falsePositives) / static_cast<double>(lookups), filter.capacity());
+    return 0;
+}
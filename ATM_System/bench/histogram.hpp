@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array> // bucket counts
+#include <bit> // bit_width
+#include <cstdint> // fixed width integers
+#include <algorithm> // min / max
+
+namespace bench
+{
+    // log-linear latency histogram (HdrHistogram style): each power of two is split into
+    // 16 linear sub-buckets, so any recorded value is reported within ~6% of its true size
+    // recording is a couple of shifts && one increment, cheap enough to wrap every operation
+    class LatencyHistogram
+    {
+        private:
+            static constexpr unsigned subBucketBits = 4;
+            static constexpr unsigned subBuckets = 1U << subBucketBits;
+            static constexpr unsigned bucketCount = (64 - subBucketBits + 1) * subBuckets;
+
+            std::array<std::uint64_t, bucketCount> counts{};
+            std::uint64_t total = 0;
+            std::uint64_t minValue = UINT64_MAX;
+            std::uint64_t maxValue = 0;
+
+            static unsigned bucketOf(std::uint64_t value)
+            {
+                if (value < subBuckets)
+                {
+                    return static_cast<unsigned>(value);
+                }
+                const unsigned magnitude = static_cast<unsigned>(std::bit_width(value)) - subBucketBits - 1;
+                const unsigned sub = static_cast<unsigned>(value >> magnitude) & (subBuckets - 1);
+                return (magnitude + 1) * subBuckets + sub;
+            }
+
+            // upper bound of the values that land in bucket
+            static std::uint64_t valueOf(unsigned bucket)
+            {
+                if (bucket < subBuckets)
+                {
+                    return bucket;
+                }
+                const unsigned magnitude = bucket / subBuckets - 1;
+                const std::uint64_t sub = (bucket % subBuckets) | subBuckets;
+                return ((sub + 1) << magnitude) - 1;
+            }
+
+        public:
+            void record(std::uint64_t value)
+            {
+                ++counts[bucketOf(value)];
+                ++total;
+                minValue = std::min(minValue, value);
+                maxValue = std::max(maxValue, value);
+            }
+
+            void merge(const LatencyHistogram & other)
+            {
+                for (unsigned i = 0; i < bucketCount; ++i)
+                {
+                    counts[i] += other.counts[i];
+                }
+                total += other.total;
+                minValue = std::min(minValue, other.minValue);
+                maxValue = std::max(maxValue, other.maxValue);
+            }
+
+            // smallest recorded bucket bound with at least quantile of the samples at or below it
+            std::uint64_t percentile(double quantile) const
+            {
+                if (total == 0)
+                {
+                    return 0;
+                }
+                const auto rank = static_cast<std::uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+                std::uint64_t seen = 0;
+                for (unsigned i = 0; i < bucketCount; ++i)
+                {
+                    seen += counts[i];
+                    if (seen >= rank)
+                    {
+                        return std::min(valueOf(i), maxValue);
+                    }
+                }
+                return maxValue;
+            }
+
+            std::uint64_t count() const
+            {
+                return total;
+            }
+
+            std::uint64_t min() const
+            {
+                return (total == 0) ? 0 : minValue;
+            }
+
+            std::uint64_t max() const
+            {
+                return maxValue;
+            }
+    };
+}
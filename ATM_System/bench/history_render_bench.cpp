@@ -0,0 +1,61 @@
+// rendering a long history: operator<< field by field vs buffered pages with one write() each
+// usage: history_render_bench [entries=100000] [pageSize=1024]
+#include <vector>
+#include <sstream>
+#include <cstdio>
+#include <fcntl.h>
+
+#include "Account.hpp"
+#include "bench.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t entries = bench::argOr(argc, argv, 1, 100'000);
+    const std::uint64_t pageSize = bench::argOr(argc, argv, 2, 1'024);
+
+    Account account("render", 0, Money::fromUnits(1'000'000'000));
+    std::vector<Operation> history;
+    for (std::uint64_t i = 0; i < entries; ++i)
+    {
+        const auto type = (i % 3 == 0) ? TransactionType::Withdrawal : TransactionType::Deposit;
+        history.push_back(Operation{type, Money::fromCents(static_cast<std::int64_t>(1 + i % 100'000))});
+    }
+    account.applyBatch(history);
+
+    const int devNull = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+    // baseline: the old streaming loop, one operator<< per field
+    std::ostringstream sink;
+    const auto streamStart = bench::Clock::now();
+    for (std::uint64_t i = 0; i < entries; ++i)
+    {
+        char timeText[formattedTimeLength];
+        const Transaction row{history[i].type, history[i].amount, 0};
+        sink << toString(row.type) << " of " << row.amount << " $ " << "on ";
+        sink.write(timeText, formatTime(row.timeStamp, timeText) - timeText) << "\n";
+    }
+    const double streamMs = bench::nanosecondsSince(streamStart, 1) / 1e6;
+    bench::doNotOptimize(sink.tellp());
+
+    HistoryRenderer renderer;
+    PageRequest request;
+    request.limit = pageSize;
+    std::uint64_t pages = 0;
+    const auto renderStart = bench::Clock::now();
+    HistoryPage page;
+    do
+    {
+        page = account.renderHistory(renderer, request);
+        renderer.flush(devNull);
+        request.offset = page.nextOffset;
+        ++pages;
+    } while (page.hasMore());
+    const double renderMs = bench::nanosecondsSince(renderStart, 1) / 1e6;
+
+    std::printf("entries %llu, page size %llu, pages %llu\n",
+                static_cast<unsigned long long>(entries), static_cast<unsigned long long>(pageSize), static_cast<unsigned long long>(pages));
+    std::printf("%-20s %10.2f ms\n", "operator<< stream", streamMs);
+    std::printf("%-20s %10.2f ms\n", "paged renderer", renderMs);
+    ::close(devNull);
+    return 0;
+}
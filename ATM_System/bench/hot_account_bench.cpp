@@ -0,0 +1,80 @@
+// many threads hammering one hot balance: CAS loop vs a mutex-guarded int64
+// usage: hot_account_bench [maxThreads=64] [opsPerThread=500000]
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <cstdio>
+
+#include "AtomicBalance.hpp"
+#include "bench.hpp"
+
+template <typename Operation>
+double run(unsigned threadCount, std::uint64_t opsPerThread, Operation operation)
+{
+    std::vector<std::thread> workers;
+    const auto start = bench::Clock::now();
+    for (unsigned t = 0; t < threadCount; ++t)
+    {
+        workers.emplace_back([&]
+        {
+            for (std::uint64_t i = 0; i < opsPerThread; ++i)
+            {
+                operation(i);
+            }
+        });
+    }
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+    return bench::nanosecondsSince(start, opsPerThread * threadCount);
+}
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t maxThreads = bench::argOr(argc, argv, 1, 64);
+    const std::uint64_t opsPerThread = bench::argOr(argc, argv, 2, 500'000);
+
+    std::printf("%8s %16s %16s\n", "threads", "cas Mops/s", "mutex Mops/s");
+
+    for (unsigned threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        // small balance so a share of withdrawals hit the overdraft check
+        AtomicBalance atomicBalance(1'000);
+        const double casNs = run(threadCount, opsPerThread, [&](std::uint64_t i)
+        {
+            std::int64_t newBalance;
+            if (i & 1)
+            {
+                bench::doNotOptimize(atomicBalance.tryDebit(150, newBalance));
+            }
+            else
+            {
+                std::int64_t unused;
+                atomicBalance.tryCredit(100, unused);
+            }
+        });
+
+        std::mutex balanceMutex;
+        std::int64_t lockedBalance = 1'000;
+        const double mutexNs = run(threadCount, opsPerThread, [&](std::uint64_t i)
+        {
+            std::lock_guard lock(balanceMutex);
+            if (i & 1)
+            {
+                if (lockedBalance >= 150)
+                {
+                    lockedBalance -= 150;
+                }
+            }
+            else
+            {
+                lockedBalance += 100;
+            }
+        });
+
+        std::printf("%8u %16.2f %16.2f\n", threadCount, 1'000.0 / casNs, 1'000.0 / mutexNs);
+    }
+
+    return 0;
+}
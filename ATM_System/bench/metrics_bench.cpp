@@ -0,0 +1,44 @@
+// cost of the always-on instrumentation: an empty MetricTimer per operation,
+// single-threaded && with every thread recording into its own slot
+// usage: metrics_bench [operations=10000000] [maxThreads=8]
+#include <vector>
+#include <thread>
+#include <cstdio>
+
+#include "Metrics.hpp"
+#include "bench.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t operations = bench::argOr(argc, argv, 1, 10'000'000);
+    const std::uint64_t maxThreads = bench::argOr(argc, argv, 2, 8);
+
+    std::printf("%8s %14s\n", "threads", "ns/timed op");
+    for (std::uint64_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        const auto start = bench::Clock::now();
+        std::vector<std::thread> threads;
+        for (std::uint64_t t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([operations]
+            {
+                for (std::uint64_t i = 0; i < operations; ++i)
+                {
+                    MetricTimer timer(MetricOp::Deposite);
+                    bench::doNotOptimize(i);
+                }
+            });
+        }
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+        // every thread did `operations` on its own core, so wall time / operations is the per-op cost
+        std::printf("%8llu %14.1f\n", static_cast<unsigned long long>(threadCount), bench::nanosecondsSince(start, operations));
+    }
+
+    const OperationSummary summary = Metrics::summarize(MetricOp::Deposite);
+    std::printf("recorded %llu operations, p50 %.0f ns\n", static_cast<unsigned long long>(summary.count),
+                summary.percentileNanoseconds(0.50, Metrics::ticksPerNanosecond()));
+    return 0;
+}
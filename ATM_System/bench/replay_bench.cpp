@@ -0,0 +1,122 @@
+// crash recovery: rebuild every account from a journal, sequentially vs partitioned across threads,
+// && check that each parallel rebuild is identical to the sequential one
+// usage: replay_bench [accounts=100000] [operations=5000000] [maxThreads=8] [path=/tmp/atm_replay_bench.wal]
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdio>
+#include <unistd.h>
+
+#include "ATM.hpp"
+#include "bench.hpp"
+
+namespace
+{
+    struct AccountState
+    {
+        int pin;
+        std::int64_t balanceCents;
+        std::vector<TransactionType> types;
+        std::vector<std::int64_t> amounts;
+        std::vector<std::int64_t> timeStamps;
+
+        bool operator==(const AccountState &) const = default;
+    };
+
+    std::unordered_map<std::string, AccountState> capture(const ATM & atm)
+    {
+        std::unordered_map<std::string, AccountState> state;
+        atm.forEachAccount([&](std::string_view accountNumber, int pin, Money balance,
+                               std::span<const TransactionType> typeColumn,
+                               std::span<const std::int64_t> amountColumn,
+                               std::span<const std::int64_t> timeStampColumn,
+                               std::uint64_t)
+        {
+            state.emplace(std::string(accountNumber), AccountState{pin, balance.getCents(),
+                {typeColumn.begin(), typeColumn.end()}, {amountColumn.begin(), amountColumn.end()}, {timeStampColumn.begin(), timeStampColumn.end()}});
+        });
+        return state;
+    }
+
+    // accounts, then a mix of deposits, withdrawals && two-leg transfers
+    void writeJournal(const std::string & path, std::uint64_t accountCount, std::uint64_t operations)
+    {
+        ::unlink(path.c_str());
+        WalConfig config;
+        config.maxBatchOps = 1 << 16;
+        config.maxBatchBytes = 8 << 20;
+        WriteAheadLog journal(path, config);
+        std::uint64_t lsn = 0;
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            lsn = journal.append(WalRecordKind::OpenAccount, bench::accountNumber(id), Money::fromUnits(1'000), 1'700'000'000, static_cast<std::int32_t>(id % 10'000));
+        }
+
+        bench::Random random(7);
+        for (std::uint64_t i = 0; i < operations; ++i)
+        {
+            const std::uint64_t fromId = random.below(accountCount);
+            const std::string from = bench::accountNumber(fromId);
+            const Money amount = Money::fromCents(static_cast<std::int64_t>(1 + random.below(10'000)));
+            const auto timeStamp = static_cast<std::int64_t>(1'700'000'000 + i / 1'000);
+            switch (random.below(4))
+            {
+                case 0:
+                {
+                    // another account, as from ATM::transfer: a settlement holds one leg per account
+                    const std::string to = bench::accountNumber((fromId + 1 + random.below(accountCount - 1)) % accountCount);
+                    const WalLeg legs[2] = {{WalRecordKind::TransferOut, from, amount}, {WalRecordKind::TransferIn, to, amount}};
+                    lsn = journal.appendSettlement(legs, timeStamp);
+                    break;
+                }
+                case 1:
+                    lsn = journal.append(WalRecordKind::Withdrawal, from, amount, timeStamp);
+                    break;
+                default:
+                    lsn = journal.append(WalRecordKind::Deposit, from, amount, timeStamp);
+                    break;
+            }
+        }
+        journal.waitDurable(lsn);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t accountCount = bench::argOr(argc, argv, 1, 100'000);
+    const std::uint64_t operations = bench::argOr(argc, argv, 2, 5'000'000);
+    const std::uint64_t maxThreads = bench::argOr(argc, argv, 3, 8);
+    const std::string path = (argc > 4) ? argv[4] : "/tmp/atm_replay_bench.wal";
+
+    writeJournal(path, accountCount, operations);
+
+    std::unordered_map<std::string, AccountState> expected;
+    double sequentialMs;
+    {
+        ATM atm;
+        atm.reserve(accountCount);
+        const auto start = bench::Clock::now();
+        const std::size_t records = atm.replayJournal(path);
+        sequentialMs = bench::nanosecondsSince(start, 1) / 1e6;
+        expected = capture(atm);
+        std::printf("%zu records, %zu accounts\n\n", records, expected.size());
+    }
+
+    bool isValid = true;
+    std::printf("%-12s %12s %10s %10s\n", "threads", "ms", "speedup", "identical");
+    std::printf("%-12s %12.1f %10s %10s\n", "sequential", sequentialMs, "1.00", "-");
+    for (std::uint64_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        ATM atm;
+        atm.reserve(accountCount);
+        const auto start = bench::Clock::now();
+        atm.replayJournalParallel(path, threadCount);
+        const double ms = bench::nanosecondsSince(start, 1) / 1e6;
+        const bool isIdentical = (capture(atm) == expected);
+        isValid = isValid && isIdentical;
+        std::printf("%-12llu %12.1f %10.2f %10s\n", static_cast<unsigned long long>(threadCount), ms, sequentialMs / ms, isIdentical ? "yes" : "NO");
+    }
+
+    ::unlink(path.c_str());
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+// load generator for SessionServer: sessions/sec && per-request latency over a Unix domain socket
+// usage: server_load_bench [clientThreads=4] [concurrentSessions=1000] [requestsPerSession=20] [journal=1]
+// with journal=1 every DEPOSIT / WITHDRAW is answered only once it is in a write-ahead log on disk
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "SessionServer.hpp"
+#include "bench.hpp"
+
+namespace
+{
+    const char * socketPath = "/tmp/atm_server_load_bench.sock";
+    const char * journalPath = "/tmp/atm_server_load_bench.wal";
+
+    int connectTo()
+    {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, socketPath);
+        if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool send(int fd, const std::string & request)
+    {
+        return ::write(fd, request.data(), request.size()) == static_cast<ssize_t>(request.size());
+    }
+
+    // blocks until one whole response line has arrived
+    bool receiveLine(int fd, std::string & response)
+    {
+        response.clear();
+        char chunk[256];
+        while (response.empty() || response.back() != '\n')
+        {
+            const ssize_t received = ::read(fd, chunk, sizeof(chunk));
+            if (received <= 0)
+            {
+                return false;
+            }
+            response.append(chunk, static_cast<std::size_t>(received));
+        }
+        return true;
+    }
+
+    // blocking request/response on one connection
+    bool roundTrip(int fd, const std::string & request, std::string & response)
+    {
+        return send(fd, request) && receiveLine(fd, response);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t clientThreads = bench::argOr(argc, argv, 1, 4);
+    const std::uint64_t concurrentSessions = bench::argOr(argc, argv, 2, 1'000);
+    const std::uint64_t requestsPerSession = bench::argOr(argc, argv, 3, 20);
+    const bool isJournaled = bench::argOr(argc, argv, 4, 1) != 0;
+    const std::uint64_t accountCount = 10'000;
+
+    ATM atm;
+    for (std::uint64_t id = 0; id < accountCount; ++id)
+    {
+        atm.addAccount(bench::accountNumber(id), 1234, Money::fromUnits(1'000'000));
+    }
+    ::unlink(journalPath);
+    std::optional<WriteAheadLog> journal;
+    if (isJournaled)
+    {
+        journal.emplace(journalPath);
+        atm.attachJournal(*journal);
+    }
+
+    SessionServer server(atm, socketPath);
+    std::thread serverThread([&server] { server.run(); });
+
+    // phase 1: short sessions back to back (connect, LOGIN, BALANCE, QUIT)
+    const std::uint64_t sessionsPerThread = concurrentSessions;
+    std::vector<std::thread> clients;
+    const auto sessionStart = bench::Clock::now();
+    for (std::uint64_t t = 0; t < clientThreads; ++t)
+    {
+        clients.emplace_back([&, t]
+        {
+            std::string response;
+            for (std::uint64_t i = 0; i < sessionsPerThread; ++i)
+            {
+                const int fd = connectTo();
+                const std::string login = "LOGIN " + bench::accountNumber((t * sessionsPerThread + i) % accountCount) + " 1234\n";
+                roundTrip(fd, login, response);
+                roundTrip(fd, "BALANCE\n", response);
+                roundTrip(fd, "QUIT\n", response);
+                ::close(fd);
+            }
+        });
+    }
+    for (auto & client : clients)
+    {
+        client.join();
+    }
+    const double sessionsPerSecond = static_cast<double>(clientThreads * sessionsPerThread) /
+                                     std::chrono::duration<double>(bench::Clock::now() - sessionStart).count();
+
+    // phase 2: concurrentSessions connections held open, each client thread round-robins over its share
+    clients.clear();
+    std::vector<std::vector<double>> latencies(clientThreads);
+    const auto requestStart = bench::Clock::now();
+    for (std::uint64_t t = 0; t < clientThreads; ++t)
+    {
+        clients.emplace_back([&, t]
+        {
+            std::vector<int> fds;
+            std::string response;
+            for (std::uint64_t i = t; i < concurrentSessions; i += clientThreads)
+            {
+                fds.push_back(connectTo());
+                roundTrip(fds.back(), "LOGIN " + bench::accountNumber(i % accountCount) + " 1234\n", response);
+            }
+            // every session has a request in flight at once, then the thread collects the answers
+            for (std::uint64_t round = 0; round < requestsPerSession; ++round)
+            {
+                const std::string request = (round & 1) ? "WITHDRAW 1.00\n" : "DEPOSIT 1.00\n";
+                const auto start = bench::Clock::now();
+                for (const int fd : fds)
+                {
+                    send(fd, request);
+                }
+                for (const int fd : fds)
+                {
+                    receiveLine(fd, response);
+                    latencies[t].push_back(std::chrono::duration<double, std::micro>(bench::Clock::now() - start).count());
+                }
+            }
+            for (const int fd : fds)
+            {
+                roundTrip(fd, "QUIT\n", response);
+                ::close(fd);
+            }
+        });
+    }
+    for (auto & client : clients)
+    {
+        client.join();
+    }
+
+    const double requestsPerSecond = static_cast<double>(concurrentSessions * requestsPerSession) /
+                                     std::chrono::duration<double>(bench::Clock::now() - requestStart).count();
+
+    server.stop();
+    serverThread.join();
+    ::unlink(journalPath);
+
+    std::vector<double> all;
+    for (const auto & perThread : latencies)
+    {
+        all.insert(all.end(), perThread.begin(), perThread.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) { return all.empty() ? 0.0 : all[static_cast<std::size_t>(p * static_cast<double>(all.size() - 1))]; };
+
+    std::printf("sessions/sec              %10.0f\n", sessionsPerSecond);
+    std::printf("concurrent sessions       %10llu\n", static_cast<unsigned long long>(concurrentSessions));
+    std::printf("journal                   %10s\n", isJournaled ? "on" : "off");
+    std::printf("requests/sec              %10.0f\n", requestsPerSecond);
+    std::printf("request latency p50 (us)  %10.1f\n", percentile(0.50));
+    std::printf("request latency p99 (us)  %10.1f\n", percentile(0.99));
+    return 0;
+}
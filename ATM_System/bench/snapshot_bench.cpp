@@ -0,0 +1,72 @@
+// startup cost: rebuilding through addAccount vs mapping a snapshot
+// usage: snapshot_bench [accounts=1000000] [historyPerAccount=4] [path=/tmp/atm_snapshot_bench.snap]
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+
+#include "ATM.hpp"
+#include "AccountSnapshot.hpp"
+#include "bench.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t accountCount = bench::argOr(argc, argv, 1, 1'000'000);
+    const std::uint64_t historyPerAccount = bench::argOr(argc, argv, 2, 4);
+    const std::string path = (argc > 3) ? argv[3] : "/tmp/atm_snapshot_bench.snap";
+
+    std::vector<Operation> history;
+    for (std::uint64_t i = 0; i < historyPerAccount; ++i)
+    {
+        history.push_back(Operation{TransactionType::Deposit, Money::fromCents(static_cast<std::int64_t>(100 + i))});
+    }
+
+    double rebuildMs;
+    {
+        const auto start = bench::Clock::now();
+        ATM atm;
+        atm.reserve(accountCount);
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            atm.addAccount(bench::accountNumber(id), 1234, Money::fromUnits(100));
+        }
+        rebuildMs = bench::nanosecondsSince(start, 1) / 1e6;
+
+        bench::MuteCout mute;
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            atm.acquire(atm.authenticate(bench::accountNumber(id), 1234))->applyBatch(history);
+        }
+
+        const auto writeStart = bench::Clock::now();
+        if (!AccountSnapshot::write(path, atm))
+        {
+            std::printf("snapshot write failed\n");
+            return 1;
+        }
+        std::printf("snapshot write        %10.1f ms\n", bench::nanosecondsSince(writeStart, 1) / 1e6);
+    }
+
+    const auto loadStart = bench::Clock::now();
+    auto snapshot = AccountSnapshot::load(path);
+    ATM restored;
+    restored.attachSnapshot(*snapshot);
+    const double loadMs = bench::nanosecondsSince(loadStart, 1) / 1e6;
+
+    bench::MuteCout mute;
+    bench::Random random(7);
+    const std::uint64_t probes = 10'000;
+    const auto probeStart = bench::Clock::now();
+    for (std::uint64_t i = 0; i < probes; ++i)
+    {
+        auto account = restored.authenticate(bench::accountNumber(random.below(accountCount)), 1234);
+        bench::doNotOptimize(account);
+    }
+    const double firstTouchNs = bench::nanosecondsSince(probeStart, probes);
+
+    std::printf("rebuild (addAccount)  %10.1f ms\n", rebuildMs);
+    std::printf("snapshot load         %10.3f ms\n", loadMs);
+    std::printf("first-touch login     %10.1f ns\n", firstTouchNs);
+
+    ::unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,90 @@
+// deposit latency while other threads keep rendering full statements of the same account:
+// statements rendered under the history lock vs from a lock-free HistorySnapshot
+// usage: snapshot_read_bench [history=100000] [deposits=200000] [maxReaders=2]
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+
+#include "Account.hpp"
+#include "bench.hpp"
+#include "histogram.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t historySize = bench::argOr(argc, argv, 1, 100'000);
+    const std::uint64_t deposits = bench::argOr(argc, argv, 2, 200'000);
+    const std::uint64_t maxReaders = bench::argOr(argc, argv, 3, 2);
+
+    std::vector<Operation> history;
+    history.reserve(historySize);
+    for (std::uint64_t i = 0; i < historySize; ++i)
+    {
+        history.push_back(Operation{(i & 1) ? TransactionType::Withdrawal : TransactionType::Deposit, Money::fromCents(static_cast<std::int64_t>(1 + i % 10'000))});
+    }
+
+    std::printf("%-9s %8s %10s %10s %10s %12s %12s\n", "readers", "mode", "p50 ns", "p99 ns", "p999 ns", "max ns", "statements");
+    for (std::uint64_t readerCount = 0; readerCount <= maxReaders; ++readerCount)
+    {
+        for (const bool isSnapshot : {false, true})
+        {
+            Account account("reader", 0, Money::fromUnits(1'000'000'000));
+            account.applyBatch(history);
+
+            std::atomic<bool> isRunning{true};
+            std::atomic<std::uint64_t> statements{0};
+            std::vector<std::thread> readers;
+            for (std::uint64_t r = 0; r < readerCount; ++r)
+            {
+                readers.emplace_back([&]
+                {
+                    HistoryRenderer renderer;
+                    while (isRunning.load(std::memory_order_relaxed))
+                    {
+                        if (isSnapshot)
+                        {
+                            const HistorySnapshot view = account.snapshot();
+                            renderer.appendPage(view, PageRequest{0, view.size()});
+                        }
+                        else
+                        {
+                            account.withTransactionsBetween(INT64_MIN, INT64_MAX, [&](const TransactionRange & range)
+                            {
+                                for (const Transaction transaction : range)
+                                {
+                                    renderer.appendLine(transaction);
+                                }
+                            });
+                        }
+                        bench::doNotOptimize(renderer.view().data());
+                        renderer.clear();
+                        statements.fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+            }
+
+            bench::LatencyHistogram latency;
+            {
+                bench::MuteCout mute;
+                for (std::uint64_t i = 0; i < deposits; ++i)
+                {
+                    const auto start = bench::Clock::now();
+                    account.deposite(Money::fromCents(100));
+                    latency.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(bench::Clock::now() - start).count()));
+                }
+            }
+
+            isRunning.store(false);
+            for (auto & reader : readers)
+            {
+                reader.join();
+            }
+
+            std::printf("%-9llu %8s %10llu %10llu %10llu %12llu %12llu\n", static_cast<unsigned long long>(readerCount), isSnapshot ? "snapshot" : "locked",
+                        static_cast<unsigned long long>(latency.percentile(0.50)), static_cast<unsigned long long>(latency.percentile(0.99)),
+                        static_cast<unsigned long long>(latency.percentile(0.999)), static_cast<unsigned long long>(latency.max()),
+                        static_cast<unsigned long long>(statements.load()));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+// random transfer graphs from several threads: single transfers vs netted settlement batches,
+// then checks that no money was created or lost (balances, histories && a journal replay)
+// usage: transfer_bench [accounts=1000] [threads=4] [transfersPerThread=200000] [batchSize=256]
+#include <vector>
+#include <thread>
+#include <cstdio>
+#include <unistd.h>
+
+#include "ATM.hpp"
+#include "bench.hpp"
+
+namespace
+{
+    constexpr std::int64_t initialCents = 100'000;
+
+    std::vector<AccountHandle> openAccounts(ATM & atm, std::uint64_t accountCount)
+    {
+        bench::MuteCout mute;
+        std::vector<AccountHandle> handles;
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            atm.addAccount(bench::accountNumber(id), 0, Money::fromCents(initialCents));
+            handles.push_back(atm.tryAuthenticate(bench::accountNumber(id), 0));
+        }
+        return handles;
+    }
+
+    Transfer randomTransfer(bench::Random & random, const std::vector<AccountHandle> & handles)
+    {
+        const std::uint64_t from = random.below(handles.size());
+        const std::uint64_t to = (from + 1 + random.below(handles.size() - 1)) % handles.size();
+        return Transfer{handles[from], handles[to], Money::fromCents(static_cast<std::int64_t>(1 + random.below(5'000)))};
+    }
+
+    // balances && histories must both add up to the money the accounts were opened with
+    bool isConserved(const ATM & atm, const std::vector<AccountHandle> & handles)
+    {
+        std::int64_t balanceSum = 0;
+        std::int64_t historySum = 0;
+        bool isConsistent = true;
+        for (const AccountHandle handle : handles)
+        {
+            const AccountLease lease = atm.acquire(handle, AccessMode::Read);
+            const Account & account = *lease;
+            const std::int64_t net = account.getTotal(TransactionType::TransferIn).getCents() - account.getTotal(TransactionType::TransferOut).getCents();
+            balanceSum += account.getBalance().getCents();
+            historySum += net;
+            isConsistent = isConsistent && (account.getBalance().getCents() == initialCents + net) && account.getBalance() >= Money{};
+        }
+        return isConsistent && historySum == 0 && balanceSum == initialCents * static_cast<std::int64_t>(handles.size());
+    }
+
+    // threads * transfersPerThread transfers, one at a time or in settle() batches
+    double run(ATM & atm, const std::vector<AccountHandle> & handles, std::uint64_t threadCount, std::uint64_t transfersPerThread, std::uint64_t batchSize)
+    {
+        const auto start = bench::Clock::now();
+        std::vector<std::thread> threads;
+        for (std::uint64_t t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&, t]
+            {
+                bench::Random random(t + 1);
+                std::vector<Transfer> batch;
+                for (std::uint64_t done = 0; done < transfersPerThread; done += batchSize)
+                {
+                    batch.clear();
+                    for (std::uint64_t i = 0; i < batchSize; ++i)
+                    {
+                        batch.push_back(randomTransfer(random, handles));
+                    }
+                    if (batchSize == 1)
+                    {
+                        bench::doNotOptimize(atm.transfer(batch[0].from, batch[0].to, batch[0].amount));
+                    }
+                    else
+                    {
+                        bench::doNotOptimize(atm.settle(batch).data());
+                    }
+                }
+            });
+        }
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+        const double seconds = std::chrono::duration<double>(bench::Clock::now() - start).count();
+        return static_cast<double>(threadCount * transfersPerThread) / seconds;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t accountCount = bench::argOr(argc, argv, 1, 1'000);
+    const std::uint64_t threadCount = bench::argOr(argc, argv, 2, 4);
+    const std::uint64_t transfersPerThread = bench::argOr(argc, argv, 3, 200'000);
+    const std::uint64_t batchSize = bench::argOr(argc, argv, 4, 256);
+
+    bool isValid = true;
+    std::printf("%-10s %16s %10s\n", "mode", "transfers/s", "conserved");
+    for (const std::uint64_t size : {std::uint64_t{1}, batchSize})
+    {
+        ATM atm;
+        const auto handles = openAccounts(atm, accountCount);
+        const double rate = run(atm, handles, threadCount, transfersPerThread, size);
+        const bool isOk = isConserved(atm, handles);
+        isValid = isValid && isOk;
+        std::printf("%-10s %16.0f %10s\n", (size == 1) ? "transfer" : "settle", rate, isOk ? "yes" : "NO");
+    }
+
+    // crash-consistency: journal a smaller run, replay it into a fresh ATM, compare every balance
+    char path[] = "/tmp/transfer_benchXXXXXX";
+    const int fd = ::mkstemp(path);
+    ::close(fd);
+    {
+        ATM journaled;
+        WriteAheadLog journal(path);
+        journaled.attachJournal(journal);
+        const auto handles = openAccounts(journaled, accountCount);
+        run(journaled, handles, threadCount, transfersPerThread / 100, batchSize);
+        run(journaled, handles, threadCount, transfersPerThread / 100, 1);
+
+        ATM replayed;
+        replayed.replayJournal(path);
+        bool isReplayed = true;
+        for (std::uint64_t id = 0; id < accountCount; ++id)
+        {
+            const AccountLease original = journaled.acquire(handles[id], AccessMode::Read);
+            const AccountLease restored = replayed.acquire(replayed.tryAuthenticate(bench::accountNumber(id), 0), AccessMode::Read);
+            isReplayed = isReplayed && restored && restored->getBalance() == original->getBalance();
+        }
+        isValid = isValid && isReplayed;
+        std::printf("%-10s %16s %10s\n", "replay", "-", isReplayed ? "yes" : "NO");
+    }
+    ::unlink(path);
+
+    return isValid ? 0 : 1;
+}
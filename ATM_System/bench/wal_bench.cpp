@@ -0,0 +1,68 @@
+// group commit: ops/sec && p99 commit latency across batch sizes
+// usage: wal_bench [threads=32] [opsPerThread=2000] [path=/tmp/atm_wal_bench.log]
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+
+#include "WriteAheadLog.hpp"
+#include "bench.hpp"
+
+int main(int argc, char ** argv)
+{
+    const std::uint64_t threadCount = bench::argOr(argc, argv, 1, 32);
+    const std::uint64_t opsPerThread = bench::argOr(argc, argv, 2, 2'000);
+    const std::string path = (argc > 3) ? argv[3] : "/tmp/atm_wal_bench.log";
+
+    std::printf("%10s %14s %16s\n", "batchOps", "ops/s", "p99 commit us");
+
+    for (std::size_t batchOps : {1, 8, 64, 512})
+    {
+        ::unlink(path.c_str());
+        std::vector<std::vector<double>> latencies(threadCount);
+
+        WalConfig config;
+        config.maxBatchOps = batchOps;
+        config.maxLatency = std::chrono::microseconds(500);
+
+        const auto start = bench::Clock::now();
+        {
+            WriteAheadLog journal(path, config);
+            std::vector<std::thread> workers;
+            for (std::uint64_t t = 0; t < threadCount; ++t)
+            {
+                workers.emplace_back([&, t]
+                {
+                    const std::string accountNumber = bench::accountNumber(t);
+                    latencies[t].reserve(opsPerThread);
+                    for (std::uint64_t i = 0; i < opsPerThread; ++i)
+                    {
+                        const auto opStart = bench::Clock::now();
+                        const auto lsn = journal.append(WalRecordKind::Deposit, accountNumber, Money::fromCents(100), 0);
+                        journal.waitDurable(lsn);
+                        latencies[t].push_back(std::chrono::duration<double, std::micro>(bench::Clock::now() - opStart).count());
+                    }
+                });
+            }
+            for (auto & worker : workers)
+            {
+                worker.join();
+            }
+        }
+        const double seconds = std::chrono::duration<double>(bench::Clock::now() - start).count();
+
+        std::vector<double> all;
+        for (const auto & perThread : latencies)
+        {
+            all.insert(all.end(), perThread.begin(), perThread.end());
+        }
+        const auto p99 = all.begin() + static_cast<std::ptrdiff_t>(all.size() * 99 / 100);
+        std::nth_element(all.begin(), p99, all.end());
+
+        std::printf("%10zu %14.0f %16.1f\n", batchOps, static_cast<double>(all.size()) / seconds, *p99);
+    }
+
+    ::unlink(path.c_str());
+    return 0;
+}
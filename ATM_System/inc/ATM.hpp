@@ -1,31 +1,878 @@
 #pragma once
 
+#include <shared_mutex> // readers (authenticate) vs writers (addAccount)
+#include <atomic> // published filter
+#include <memory> // filter generations
+#include <vector> // retired filters, settlement positions
+#include <span> // settlement batches
+#include <algorithm> // sort positions into lock order
+#include <functional> // std::less on account pointers
+#include <thread> // parallel replay workers
 #include "Account.hpp"
+#include "AccountIndex.hpp"
+#include "AccountFilter.hpp"
+#include "AccountPool.hpp"
+#include "AccountCache.hpp"
+#include "WriteAheadLog.hpp"
+#include "AccountSnapshot.hpp"
+#include "Metrics.hpp"
+
+// thread-safe: the account table is guarded by a reader/writer lock,
+// each Account guards its own state, so operations on different accounts run in parallel
+// accounts are pooled: authenticate hands out an AccountHandle, acquire() resolves it without locking
+// built on an AccountStore, the table is an AccountCache instead: accounts are faulted in on use &&
+// written back when evicted, a handle names the account's store position && acquire() pins it resident
+// a Bloom filter in front of the table turns away unknown account numbers before any lock is taken
+// transfers lock the accounts involved in address order, so they never deadlock
+
+// one account-to-account movement of a settlement batch
+struct Transfer
+{
+    AccountHandle from;
+    AccountHandle to;
+    Money amount;
+};
 
 class ATM
 {
     private:
-        std::vector<std::shared_ptr<Account>> accounts;
+        AccountPool accounts;
+        AccountIndex index; // account number -> slot in accounts
+        AccountStore * store = nullptr; // optional: every account lives there, the pool && index stay empty
+        std::unique_ptr<AccountCache> cache; // the resident accounts of store
+        mutable std::shared_mutex tableMutex;
+        WriteAheadLog * journal = nullptr; // optional, set once before serving
+        const AccountSnapshot * snapshot = nullptr; // optional, accounts are materialized on first use
+
+        // every account number in the pool, the store or the snapshot; rebuilt bigger when full
+        // older generations stay alive (at most as much memory as the current one) since readers never lock
+        std::vector<std::unique_ptr<AccountFilter>> filters;
+        std::atomic<const AccountFilter *> filter{nullptr};
+        std::size_t filteredCount = 0;
+
+        std::string_view accountNumberAt(std::size_t position) const
+        {
+            return accounts.at(static_cast<std::uint32_t>(position)).getAccountNumber();
+        }
+
+        // call with tableMutex held
+        std::size_t findLocked(std::string_view accountNumber) const
+        {
+            auto keyAt = [this](std::size_t position) { return accountNumberAt(position); };
+            return index.find(accountNumber, keyAt);
+        }
+
+        // call with tableMutex held exclusively: falls back to the snapshot && pools that one account;
+        // its history stays in the mapping until first used, so the exclusive lock never covers a copy of it
+        std::size_t findOrMaterializeLocked(std::string_view accountNumber)
+        {
+            const std::size_t position = findLocked(accountNumber);
+            if (position != AccountIndex::npos || snapshot == nullptr)
+            {
+                return position;
+            }
+
+            const SnapshotAccount * record = snapshot->find(accountNumber);
+            if (record == nullptr)
+            {
+                return AccountIndex::npos;
+            }
+            const std::size_t inserted = insertLocked(accountNumber, record->pin, Money::fromCents(record->balanceCents), true);
+            if (inserted != AccountIndex::npos)
+            {
+                Account & account = accounts.at(static_cast<std::uint32_t>(inserted));
+                account.attachHistory(snapshot->typeColumn(*record), snapshot->amountColumn(*record), snapshot->timeStampColumn(*record));
+                account.setJournalLsn(record->journalLsn);
+            }
+            return inserted;
+        }
+
+        // with a store: the account through the cache, an account only the snapshot has is copied into the store
+        // first (the snapshot is attached before serving); empty if it is unknown || every resident account is pinned
+        AccountLease faultIn(std::string_view accountNumber, AccessMode mode)
+        {
+            AccountLease lease = cache->acquire(accountNumber, mode);
+            if (lease || snapshot == nullptr || store->contains(accountNumber))
+            {
+                return lease;
+            }
+            const SnapshotAccount * record = snapshot->find(accountNumber);
+            if (record == nullptr)
+            {
+                return lease;
+            }
+            Account account(accountNumber, record->pin, Money::fromCents(record->balanceCents));
+            account.loadHistory(snapshot->typeColumn(*record), snapshot->amountColumn(*record), snapshot->timeStampColumn(*record));
+            account.setJournalLsn(record->journalLsn);
+            store->add(account); // fails if another lookup stored it first, it is stored either way
+            return cache->acquire(accountNumber, mode);
+        }
+
+        // call with tableMutex held exclusively: replayLocked for an ATM built on a store
+        bool replayStoredLocked(const WalRecord & record)
+        {
+            if (record.kind == WalRecordKind::OpenAccount)
+            {
+                const bool isInSnapshot = (snapshot != nullptr) && snapshot->contains(record.accountNumber);
+                if (isInSnapshot || store->contains(record.accountNumber))
+                {
+                    return false;
+                }
+                Account account(record.accountNumber, record.pin, record.amount);
+                account.setJournalLsn(record.lsn);
+                if (!store->add(account))
+                {
+                    return false;
+                }
+                addToFilterLocked(record.accountNumber);
+                return true;
+            }
+
+            const AccountLease lease = faultIn(record.accountNumber, AccessMode::Write);
+            if (!lease || lease->getJournalLsn() >= record.lsn)
+            {
+                return false;
+            }
+            lease->restore(transactionTypeOf(record.kind), record.amount, record.timeStamp, record.lsn);
+            return true;
+        }
+
+        // call with tableMutex held (exclusively unless every account it may touch is already live):
+        // applies one replayed journal record, unless the account (e.g. from a snapshot) already includes it
+        // returns true if it was applied
+        bool replayLocked(const WalRecord & record)
+        {
+            if (cache != nullptr)
+            {
+                return replayStoredLocked(record);
+            }
+            if (record.kind == WalRecordKind::OpenAccount)
+            {
+                const bool isInSnapshot = (snapshot != nullptr) && snapshot->contains(record.accountNumber);
+                const std::size_t inserted = isInSnapshot ? AccountIndex::npos : insertLocked(record.accountNumber, record.pin, record.amount);
+                if (inserted != AccountIndex::npos)
+                {
+                    accounts.at(static_cast<std::uint32_t>(inserted)).setJournalLsn(record.lsn);
+                }
+                return inserted != AccountIndex::npos;
+            }
+
+            const std::size_t position = findOrMaterializeLocked(record.accountNumber);
+            if (position == AccountIndex::npos)
+            {
+                return false;
+            }
+            Account & account = accounts.at(static_cast<std::uint32_t>(position));
+            if (account.getJournalLsn() >= record.lsn)
+            {
+                return false;
+            }
+            account.restore(transactionTypeOf(record.kind), record.amount, record.timeStamp, record.lsn);
+            return true;
+        }
+
+        // call with tableMutex held exclusively: replaces the filter by one sized for expectedKeys,
+        // holding every pooled, stored && snapshot account number
+        void rebuildFilterLocked(std::size_t expectedKeys)
+        {
+            auto rebuilt = std::make_unique<AccountFilter>(expectedKeys);
+            filteredCount = 0;
+            accounts.forEach([&](AccountHandle, const Account & account)
+            {
+                rebuilt->insert(hashAccountNumber(account.getAccountNumber()));
+                ++filteredCount;
+            });
+            if (store != nullptr)
+            {
+                store->forEachNumber([&](std::string_view accountNumber)
+                {
+                    rebuilt->insert(hashAccountNumber(accountNumber));
+                    ++filteredCount;
+                });
+            }
+            for (std::size_t position = 0; snapshot != nullptr && position < snapshot->size(); ++position)
+            {
+                rebuilt->insert(hashAccountNumber(snapshot->accountNumberAt(position)));
+                ++filteredCount;
+            }
+
+            filter.store(rebuilt.get(), std::memory_order_release);
+            filters.push_back(std::move(rebuilt));
+        }
+
+        // call with tableMutex held exclusively, once the account is pooled (|| stored)
+        void addToFilterLocked(std::string_view accountNumber)
+        {
+            if (filteredCount + 1 > filters.back()->capacity())
+            {
+                rebuildFilterLocked((filteredCount + 1) * 2); // picks up the new account from the pool (|| store)
+                return;
+            }
+            filters.back()->insert(hashAccountNumber(accountNumber));
+            ++filteredCount;
+        }
+
+        // call with tableMutex held, see isJournalCovered
+        bool isJournalCoveredLocked(const std::string & path) const
+        {
+            const std::uint64_t journalBase = WalReader(path).baseLsn();
+            return journalBase == 0 || (snapshot != nullptr && snapshot->coveredLsn() >= journalBase);
+        }
+
+        // call with tableMutex held exclusively, returns the new slot (npos if the number is taken || the pool is full)
+        // snapshot accounts are already in the filter
+        std::size_t insertLocked(std::string_view accountNumber, int PIN, Money initialBalance, bool isFiltered = false)
+        {
+            auto keyAt = [this](std::size_t position) { return accountNumberAt(position); };
+            const AccountHandle handle = accounts.emplace(accountNumber, PIN, initialBalance);
+            if (!handle)
+            {
+                return AccountIndex::npos;
+            }
+            if (!index.insert(accountNumber, handle.slot, keyAt))
+            {
+                accounts.release(handle);
+                return AccountIndex::npos;
+            }
+            if (!isFiltered)
+            {
+                addToFilterLocked(accountNumber);
+            }
+
+            accounts.at(handle.slot).attachJournal(journal);
+            return handle.slot;
+        }
+
+        // addAccount for an ATM built on a store: the cache journals it && stores it, it is filtered once stored
+        bool addStoredAccount(std::string_view accountNumber, int PIN, Money initialBalance)
+        {
+            const bool isInSnapshot = (snapshot != nullptr) && snapshot->contains(accountNumber);
+            if (isInSnapshot || store->contains(accountNumber))
+            {
+                std::cout << "Account " << accountNumber << " already exists!\n";
+                return false;
+            }
+            if (!cache->addAccount(accountNumber, PIN, initialBalance))
+            {
+                return false;
+            }
+            std::unique_lock lock(tableMutex);
+            addToFilterLocked(accountNumber);
+            return true;
+        }
 
     public:
-        void addAccount(std::string_view accountNumber, int PIN, double initialBalance)
+        ATM()
+        {
+            rebuildFilterLocked(1024);
+        }
+
+        // every account lives in accountStore (which must outlive the ATM), at most residentAccounts of them
+        // in memory; that bounds the accounts in use at once too: each held AccountLease pins one
+        ATM(AccountStore & accountStore, std::size_t residentAccounts) : store(&accountStore), cache(std::make_unique<AccountCache>(accountStore, residentAccounts))
+        {
+            rebuildFilterLocked(std::max<std::size_t>(accountStore.size() * 2, 1024));
+        }
+
+        void reserve(std::size_t expectedAccounts)
+        {
+            std::unique_lock lock(tableMutex);
+            index.reserve(expectedAccounts);
+            if (expectedAccounts > filters.back()->capacity())
+            {
+                rebuildFilterLocked(expectedAccounts);
+            }
+        }
+
+        // longest account number accepted: every account must fit a snapshot record
+        static constexpr std::size_t maxAccountNumberLength = SnapshotAccount::maxNumberLength;
+
+        bool addAccount(std::string_view accountNumber, int PIN, Money initialBalance)
+        {
+            MetricTimer timer(MetricOp::AddAccount);
+            if (accountNumber.size() > maxAccountNumberLength)
+            {
+                timer.failed();
+                std::cout << "Account number " << accountNumber << " is longer than " << maxAccountNumberLength << " characters!\n";
+                return false;
+            }
+
+            if (cache != nullptr)
+            {
+                const bool isAdded = addStoredAccount(accountNumber, PIN, initialBalance);
+                if (!isAdded)
+                {
+                    timer.failed();
+                }
+                return isAdded;
+            }
+
+            std::uint64_t lsn = 0;
+            {
+                std::unique_lock lock(tableMutex);
+                if (accounts.isFull())
+                {
+                    lock.unlock();
+                    timer.failed();
+                    std::cout << "No room for account " << accountNumber << ", the ATM is full!\n";
+                    return false;
+                }
+                const bool isInSnapshot = (snapshot != nullptr) && snapshot->contains(accountNumber);
+                if (isInSnapshot || insertLocked(accountNumber, PIN, initialBalance) == AccountIndex::npos)
+                {
+                    lock.unlock();
+                    timer.failed();
+                    std::cout << "Account " << accountNumber << " already exists!\n";
+                    return false;
+                }
+                if (journal != nullptr)
+                {
+                    lsn = journal->append(WalRecordKind::OpenAccount, accountNumber, initialBalance, getEpochSeconds(), PIN);
+                    accounts.at(static_cast<std::uint32_t>(findLocked(accountNumber))).setJournalLsn(lsn);
+                }
+            }
+
+            if (journal != nullptr && !journal->waitDurable(lsn))
+            {
+                timer.failed();
+                return false;
+            }
+            return true;
+        }
+
+        // from now on every account change is journaled before it is reported
+        void attachJournal(WriteAheadLog & wal)
+        {
+            std::unique_lock lock(tableMutex);
+            journal = &wal;
+            accounts.forEach([this](AccountHandle, Account & account) { account.attachJournal(journal); });
+            if (cache != nullptr)
+            {
+                cache->attachJournal(journal);
+            }
+        }
+
+        // nullptr until attachJournal
+        WriteAheadLog * getJournal() const
+        {
+            return journal;
+        }
+
+        // a checkpointed journal starts after its base lsn, the records up to it only exist in the snapshot
+        // that covered them: false if no attached snapshot does, replaying the rest onto the table would
+        // rebuild wrong balances (or accounts without their opening record); call after attachSnapshot
+        bool isJournalCovered(const std::string & path) const
+        {
+            std::shared_lock lock(tableMutex);
+            return isJournalCoveredLocked(path);
+        }
+
+        // rebuilds accounts && histories from a journal file, call before attachJournal
+        // with a snapshot attached, only the records it doesn't include yet are applied; with a store, only
+        // those the stored accounts don't include yet (as AccountCache::recover), && the store is flushed after
+        // returns the number of records applied, nothing is applied from a journal that isn't covered
+        std::size_t replayJournal(const std::string & path)
+        {
+            std::unique_lock lock(tableMutex);
+            if (!isJournalCoveredLocked(path))
+            {
+                return 0;
+            }
+            std::size_t replayed = 0;
+            WriteAheadLog::replay(path, [&](const WalRecord & record)
+            {
+                replayed += replayLocked(record) ? 1 : 0;
+            });
+            if (cache != nullptr)
+            {
+                cache->flush();
+            }
+            return replayed;
+        }
+
+        // call with tableMutex held exclusively: one chunk of replayJournalParallel, adds the records
+        // applied to replayed; false if the chunk ends in a corrupt record (nothing after it is applied)
+        bool replayChunkLocked(const WalContents & log, std::size_t workerCount, std::size_t & replayed)
+        {
+            const std::size_t partitionCount = workerCount * 8; // small partitions even out skewed accounts
+            const std::size_t sliceSize = (log.size() + workerCount - 1) / workerCount;
+
+            struct Slice
+            {
+                std::vector<WalRecord> opened;
+                std::vector<std::vector<WalRecord>> partitions;
+                std::size_t end = 0; // first record not decoded (the first corrupt one, or the slice end)
+            };
+            std::vector<Slice> slices(workerCount);
+
+            auto runWorkers = [workerCount](auto task)
+            {
+                std::vector<std::jthread> workers;
+                workers.reserve(workerCount);
+                for (std::size_t worker = 0; worker < workerCount; ++worker)
+                {
+                    workers.emplace_back(task, worker);
+                }
+            };
+
+            runWorkers([&](std::size_t worker)
+            {
+                Slice & slice = slices[worker];
+                slice.partitions.resize(partitionCount);
+                std::vector<WalRecord> decoded;
+                const std::size_t begin = std::min(worker * sliceSize, log.size());
+                slice.end = std::min(begin + sliceSize, log.size());
+                for (std::size_t record = begin; record < slice.end; ++record)
+                {
+                    decoded.clear();
+                    if (!log.decode(record, decoded))
+                    {
+                        slice.end = record;
+                        break;
+                    }
+                    for (const WalRecord & event : decoded)
+                    {
+                        if (event.kind == WalRecordKind::OpenAccount)
+                        {
+                            slice.opened.push_back(event);
+                        }
+                        else
+                        {
+                            slice.partitions[hashAccountNumber(event.accountNumber) % partitionCount].push_back(event);
+                        }
+                    }
+                }
+            });
+
+            // slices past the first corrupt record are dropped, as a sequential replay would never reach them
+            std::size_t validSlices = 0;
+            while (validSlices < workerCount)
+            {
+                const Slice & slice = slices[validSlices++];
+                if (slice.end < std::min(validSlices * sliceSize, log.size()))
+                {
+                    break;
+                }
+            }
+
+            std::atomic<std::size_t> applied{0};
+            for (std::size_t i = 0; i < validSlices; ++i)
+            {
+                for (const WalRecord & event : slices[i].opened)
+                {
+                    applied += replayLocked(event) ? 1 : 0;
+                }
+            }
+
+            // the index is only read from here on, so lookups run concurrently
+            std::atomic<std::size_t> nextPartition{0};
+            std::vector<std::vector<const WalRecord *>> unresolved(partitionCount);
+            runWorkers([&](std::size_t)
+            {
+                for (std::size_t partition = nextPartition++; partition < partitionCount; partition = nextPartition++)
+                {
+                    for (std::size_t i = 0; i < validSlices; ++i)
+                    {
+                        for (const WalRecord & event : slices[i].partitions[partition])
+                        {
+                            if (findLocked(event.accountNumber) == AccountIndex::npos)
+                            {
+                                unresolved[partition].push_back(&event);
+                                continue;
+                            }
+                            applied += replayLocked(event) ? 1 : 0;
+                        }
+                    }
+                }
+            });
+
+            for (const auto & partition : unresolved)
+            {
+                for (const WalRecord * event : partition)
+                {
+                    applied += replayLocked(*event) ? 1 : 0;
+                }
+            }
+            replayed += applied;
+            return slices[validSlices - 1].end == std::min(validSlices * sliceSize, log.size());
+        }
+
+        // same result as replayJournal, rebuilt on workerCount threads; the log is read a chunk of
+        // records at a time (memory stays at one chunk + its decoded records), && each chunk is replayed:
+        //   1. each worker checks && decodes one contiguous slice of the chunk, bucketing the events by account
+        //      (slices are later read back in log order, so every account still sees its events in order)
+        //   2. accounts are opened in log order (the pool && index are single-writer)
+        //   3. workers claim account partitions && apply them, each account belongs to exactly one partition
+        //   4. accounts that only exist in an attached snapshot are materialized && caught up sequentially
+        // like replayJournal it stops at the first torn or corrupt record && refuses a journal that
+        // isn't covered; call before attachJournal
+        // with a store it is replayJournal: the cache bounds the accounts a replay can have in flight, not the workers
+        std::size_t replayJournalParallel(const std::string & path, std::size_t workerCount = std::thread::hardware_concurrency(),
+                                          std::size_t chunkBytes = WalReader::defaultChunkBytes)
         {
-            accounts.emplace_back(std::make_shared<Account>(accountNumber, PIN, initialBalance));
+            if (cache != nullptr)
+            {
+                return replayJournal(path);
+            }
+            std::unique_lock lock(tableMutex);
+            if (!isJournalCoveredLocked(path))
+            {
+                return 0;
+            }
+            workerCount = std::max<std::size_t>(workerCount, 1);
+            WalReader reader(path, chunkBytes);
+            WalContents chunk;
+            std::size_t replayed = 0;
+            bool isIntact = true;
+            while (isIntact && reader.next(chunk))
+            {
+                isIntact = replayChunkLocked(chunk, workerCount, replayed);
+            }
+            return replayed;
         }
 
-        std::shared_ptr<Account> authenticate(std::string_view accountNumber, int pinNum)
+        // serve straight from a mapped snapshot: nothing is parsed up front,
+        // each account is pooled the first time it is used (its history on first access to it),
+        // || copied into the store; call before serving, mapped must outlive the ATM
+        void attachSnapshot(const AccountSnapshot & mapped)
         {
-            // to do (accountNumber && pinNumber)
-            for (const auto & accountIter : accounts)
+            std::unique_lock lock(tableMutex);
+            snapshot = &mapped;
+            const std::size_t stored = (store != nullptr) ? store->size() : 0;
+            rebuildFilterLocked((accounts.size() + stored + mapped.size()) * 2);
+        }
+
+        // dormant tier sweep: compresses the history of every live (resident) account untouched for idleSeconds,
+        // run it periodically (e.g. from a maintenance thread); compressed accounts expand again on access
+        // returns the number of accounts compressed by this pass
+        std::size_t compressDormant(std::int64_t idleSeconds)
+        {
+            const std::int64_t now = getEpochSeconds();
+            if (cache != nullptr)
             {
-                if (accountIter->authenticate(pinNum))
+                std::size_t compressed = 0;
+                cache->forEachResident([&](Account & account) { compressed += account.compressIfIdle(now, idleSeconds) ? 1 : 0; });
+                return compressed;
+            }
+
+            std::vector<Account *> live;
+            {
+                std::shared_lock lock(tableMutex);
+                live.reserve(accounts.size());
+                accounts.forEach([&live](AccountHandle, Account & account) { live.push_back(&account); });
+            }
+
+            std::size_t compressed = 0;
+            for (Account * accountIter : live)
+            {
+                compressed += accountIter->compressIfIdle(now, idleSeconds) ? 1 : 0;
+            }
+            return compressed;
+        }
+
+        // visit(accountNumber, PIN, balance, typeColumn, amountColumn, timeStampColumn, journalLsn) for every account,
+        // live ones copied into scratch columns under their own history lock (dormant ones stay compressed),
+        // not-yet-materialized ones straight from the snapshot; journalLsn is the last journal record included
+        // with a store, resident accounts are read through the cache && the others from the store, none is faulted in
+        // the table lock is only held to copy the account list, so the ATM keeps serving
+        // false if a damaged snapshot (|| stored) record had to be skipped: the visit missed an account
+        template <typename Visitor>
+        bool forEachAccount(Visitor visit) const
+        {
+            // pooled accounts never move, so pointers collected under the lock stay valid after it
+            std::vector<const Account *> live;
+            const AccountSnapshot * mapped;
+            {
+                std::shared_lock lock(tableMutex);
+                live.reserve(accounts.size());
+                accounts.forEach([&live](AccountHandle, const Account & account) { live.push_back(&account); });
+                mapped = snapshot;
+            }
+
+            std::vector<TransactionType> types;
+            std::vector<std::int64_t> amounts;
+            std::vector<std::int64_t> timeStamps;
+            auto visitLive = [&](const Account & account)
+            {
+                account.exportState([&](int PIN, Money balance, const TransactionLog & log, std::uint64_t journalLsn)
                 {
-                    std::cout << "Authentication Successful!\n";
-                    return accountIter;
+                    types.clear();
+                    amounts.clear();
+                    timeStamps.clear();
+                    log.forEachRow([&](const Transaction & row)
+                    {
+                        types.push_back(row.type);
+                        amounts.push_back(row.amount.getCents());
+                        timeStamps.push_back(row.timeStamp);
+                    });
+                    visit(account.getAccountNumber(), PIN, balance, std::span<const TransactionType>(types),
+                          std::span<const std::int64_t>(amounts), std::span<const std::int64_t>(timeStamps), journalLsn);
+                });
+            };
+            for (const Account * accountIter : live)
+            {
+                visitLive(*accountIter);
+            }
+
+            bool isComplete = true;
+            std::vector<std::string> stored;
+            if (store != nullptr)
+            {
+                store->forEachNumber([&stored](std::string_view accountNumber) { stored.emplace_back(accountNumber); });
+                for (const std::string & accountNumber : stored)
+                {
+                    // a resident copy may be newer than the stored one; an evicted account was written back first
+                    const AccountLease resident = cache->peek(accountNumber);
+                    const std::unique_ptr<Account> loaded = resident ? nullptr : store->load(accountNumber);
+                    if (!resident && loaded == nullptr)
+                    {
+                        isComplete = false;
+                        continue;
+                    }
+                    visitLive(resident ? *resident : *loaded);
                 }
             }
 
+            if (mapped == nullptr)
+            {
+                return isComplete;
+            }
+
+            // every account visited above: pooled ones, then stored ones (an account copied into the store
+            // after the list was taken is still visited once, from the snapshot)
+            AccountIndex liveIndex;
+            auto keyAt = [&](std::size_t position)
+            {
+                return (position < live.size()) ? live[position]->getAccountNumber() : std::string_view(stored[position - live.size()]);
+            };
+            liveIndex.reserve(live.size() + stored.size());
+            for (std::size_t position = 0; position < live.size() + stored.size(); ++position)
+            {
+                liveIndex.insert(keyAt(position), position, keyAt);
+            }
+
+            for (std::size_t position = 0; position < mapped->size(); ++position)
+            {
+                const SnapshotAccount * record = mapped->at(position);
+                if (record == nullptr)
+                {
+                    isComplete = false;
+                    continue;
+                }
+                if (liveIndex.find(record->getAccountNumber(), keyAt) == AccountIndex::npos)
+                {
+                    visit(record->getAccountNumber(), record->pin, Money::fromCents(record->balanceCents),
+                          mapped->typeColumn(*record), mapped->amountColumn(*record), mapped->timeStampColumn(*record), record->journalLsn);
+                }
+            }
+            return isComplete;
+        }
+
+        // one filter probe, then one probe into the index + one PIN check, no console output (network sessions)
+        AccountHandle tryAuthenticate(std::string_view accountNumber, int pinNum)
+        {
+            MetricTimer timer(MetricOp::Authenticate);
+            AccountHandle handle;
+            if (!filter.load(std::memory_order_acquire)->mayContain(hashAccountNumber(accountNumber)))
+            {
+                timer.failed();
+                return handle;
+            }
+
+            if (cache != nullptr)
+            {
+                const AccountLease lease = faultIn(accountNumber, AccessMode::Read);
+                if (lease && lease->authenticate(pinNum))
+                {
+                    handle = AccountHandle{static_cast<std::uint32_t>(store->positionOf(accountNumber)), 1}; // positions never go stale
+                }
+            }
+            else
+            {
+                std::shared_lock lock(tableMutex);
+                std::size_t position = findLocked(accountNumber);
+                if (position == AccountIndex::npos && snapshot != nullptr)
+                {
+                    lock.unlock();
+                    std::unique_lock exclusiveLock(tableMutex);
+                    position = findOrMaterializeLocked(accountNumber);
+                    if (position != AccountIndex::npos && accounts.at(static_cast<std::uint32_t>(position)).authenticate(pinNum))
+                    {
+                        handle = accounts.handleAt(static_cast<std::uint32_t>(position));
+                    }
+                }
+                else if (position != AccountIndex::npos && accounts.at(static_cast<std::uint32_t>(position)).authenticate(pinNum))
+                {
+                    handle = accounts.handleAt(static_cast<std::uint32_t>(position));
+                }
+            }
+
+            if (!handle)
+            {
+                timer.failed();
+            }
+            return handle;
+        }
+
+        AccountHandle authenticate(std::string_view accountNumber, int pinNum)
+        {
+            const AccountHandle handle = tryAuthenticate(accountNumber, pinNum);
+            if (handle)
+            {
+                std::cout << "Authentication Successful!\n";
+                return handle;
+            }
+
             std::cout << "Authentication Failed!\n";
-            return nullptr;
+            return AccountHandle{};
+        }
+
+        // atomic: both balances && histories change together, journaled as one record
+        OperationResult transfer(AccountHandle from, AccountHandle to, Money amount)
+        {
+            MetricTimer timer(MetricOp::Transfer);
+            const AccountLease sourceLease = acquire(from);
+            const AccountLease targetLease = acquire(to);
+            Account * source = sourceLease.get();
+            Account * target = targetLease.get();
+            OperationResult result;
+            if (source == nullptr || target == nullptr || source == target)
+            {
+                result = OperationResult::InvalidAccount;
+            }
+            else if (amount <= Money{})
+            {
+                result = OperationResult::InvalidAmount;
+            }
+            else
+            {
+                NetPosition positions[2] = {{source, -amount.getCents()}, {target, amount.getCents()}};
+                if (std::less<>{}(target, source))
+                {
+                    std::swap(positions[0], positions[1]);
+                }
+                result = Account::applyNetted(positions);
+            }
+
+            if (result != OperationResult::Applied)
+            {
+                timer.failed();
+            }
+            return result;
+        }
+
+        // settlement: nets the whole batch into one movement per account && applies it in one step
+        // (one lock per account, one history entry per account, one journal record),
+        // if some account can't cover its net debit or would go over its withdrawal limits (or the batch
+        // touches more accounts than one journal record holds) the batch falls back to one transfer at a
+        // time, each of them still atomic; so does a batch whose accounts don't all fit in the cache at once
+        std::vector<OperationResult> settle(std::span<const Transfer> transfers)
+        {
+            MetricTimer timer(MetricOp::Settle);
+            std::vector<OperationResult> results(transfers.size(), OperationResult::Applied);
+            std::vector<AccountLease> leases; // keeps every account of the batch resident until it is applied
+            std::vector<NetPosition> legs;
+            leases.reserve(transfers.size() * 2);
+            legs.reserve(transfers.size() * 2);
+            bool isPinned = true;
+            for (std::size_t i = 0; i < transfers.size(); ++i)
+            {
+                AccountLease sourceLease = acquire(transfers[i].from);
+                AccountLease targetLease = acquire(transfers[i].to);
+                Account * source = sourceLease.get();
+                Account * target = targetLease.get();
+                if (cache != nullptr && (source == nullptr || target == nullptr))
+                {
+                    isPinned = false; // maybe just every resident account pinned: transfer() tells which
+                }
+                else if (source == nullptr || target == nullptr || source == target)
+                {
+                    results[i] = OperationResult::InvalidAccount;
+                }
+                else if (transfers[i].amount <= Money{})
+                {
+                    results[i] = OperationResult::InvalidAmount;
+                }
+                else
+                {
+                    legs.push_back(NetPosition{source, -transfers[i].amount.getCents()});
+                    legs.push_back(NetPosition{target, transfers[i].amount.getCents()});
+                    leases.push_back(std::move(sourceLease));
+                    leases.push_back(std::move(targetLease));
+                }
+            }
+
+            // sorting by account groups the legs && yields the global lock order in one go
+            std::sort(legs.begin(), legs.end(), [](const NetPosition & a, const NetPosition & b) { return std::less<>{}(a.account, b.account); });
+            std::vector<NetPosition> positions;
+            bool isNettable = true;
+            for (const NetPosition & leg : legs)
+            {
+                if (!positions.empty() && positions.back().account == leg.account)
+                {
+                    Money net = Money::fromCents(positions.back().deltaCents);
+                    isNettable = isNettable && Money::tryAdd(net, Money::fromCents(leg.deltaCents), net);
+                    positions.back().deltaCents = net.getCents();
+                }
+                else
+                {
+                    positions.push_back(leg);
+                }
+            }
+            std::erase_if(positions, [](const NetPosition & position) { return position.deltaCents == 0; });
+
+            // one transfer at a time needs two resident accounts, not the whole batch
+            OperationResult netResult = OperationResult::InvalidAccount;
+            if (isPinned)
+            {
+                netResult = isNettable ? Account::applyNetted(positions) : OperationResult::BalanceOverflow;
+            }
+            leases.clear(); // the fallback below pins its own
+            for (std::size_t i = 0; i < transfers.size(); ++i)
+            {
+                if (results[i] != OperationResult::Applied)
+                {
+                    continue;
+                }
+                if (netResult == OperationResult::Applied || netResult == OperationResult::JournalFailure)
+                {
+                    results[i] = netResult;
+                }
+                else
+                {
+                    results[i] = transfer(transfers[i].from, transfers[i].to, transfers[i].amount);
+                }
+            }
+
+            if (std::any_of(results.begin(), results.end(), [](OperationResult result) { return result != OperationResult::Applied; }))
+            {
+                timer.failed();
+            }
+            return results;
+        }
+
+        // the account a handle names, empty for a stale or empty handle; without a store it is lock-free
+        // && the lease pins nothing, with one it faults the account in && keeps it resident while held
+        // (empty if every resident account is pinned); Read leases don't mark the account for write-back
+        AccountLease acquire(AccountHandle handle, AccessMode mode = AccessMode::Write) const
+        {
+            if (cache == nullptr)
+            {
+                return AccountLease(accounts.get(handle));
+            }
+            const std::string accountNumber = handle ? store->numberAt(handle.slot) : std::string();
+            return accountNumber.empty() ? AccountLease() : cache->acquire(accountNumber, mode);
+        }
+
+        // hit rate && evictions of the resident accounts, all zero without a store
+        CacheStats cacheStats() const
+        {
+            return (cache != nullptr) ? cache->stats() : CacheStats{};
+        }
+
+        // writes every changed resident account back && syncs the store; true without a store
+        bool flush()
+        {
+            return (cache == nullptr) || cache->flush();
         }
-};
\ No newline at end of file
+};
@@ -8,87 +8,685 @@
 #include <algorithm> // sorting algorithms
 #include <ctime> // get current time
 #include <iomanip> // manipulation formating of time
+#include <mutex> // per-account lock
+#include <atomic> // last access time
+#include <optional> // dormant snapshots
+#include <span> // batch input
+#include "Money.hpp"
 #include "Transactions.hpp"
+#include "AtomicBalance.hpp"
+#include "Operation.hpp"
+#include "WriteAheadLog.hpp"
+#include "HistoryRenderer.hpp"
+#include "TransactionCodec.hpp"
+#include "Metrics.hpp"
+
+// the history row a replayed journal record becomes
+inline TransactionType transactionTypeOf(WalRecordKind kind)
+{
+    switch (kind)
+    {
+        case WalRecordKind::Deposit:     return TransactionType::Deposit;
+        case WalRecordKind::TransferIn:  return TransactionType::TransferIn;
+        case WalRecordKind::TransferOut: return TransactionType::TransferOut;
+        default:                         return TransactionType::Withdrawal;
+    }
+}
+
+// where an operation starts, to undo it if its journal record never becomes durable
+struct UndoPoint
+{
+    std::size_t historyPosition = 0; // first history row of the operation
+    std::uint64_t journalLsn = 0; // the account's journal position before it
+};
+
+// an applied batch whose journal record may not be durable yet, see Account::beginBatch
+struct PendingBatch
+{
+    std::vector<OperationResult> results;
+    std::uint64_t lsn = 0; // last journal record of the batch, 0 if there is none
+    UndoPoint undo;
+    std::int64_t appliedCents = 0; // net balance change
+};
 
 class Account 
 {
     private:
         std::string accountNumber;
         int PIN;
-        double balance;
-        std::vector<Transaction> transactions;
+        AtomicBalance balance; // lock-free, in cents
+        mutable TransactionLog transactions; // mutable: a dormant log is expanded again on first read
+        mutable std::mutex historyMutex; // guards transactions only
+        mutable std::atomic<std::int64_t> lastAccess{getEpochSeconds()}; // epoch seconds, drives the dormant tier
+        WriteAheadLog * journal = nullptr; // optional, set once before serving
+        WithdrawalLimits limits; // guarded by historyMutex
+        std::uint64_t journalLsn = 0; // last journal record applied to this account, guarded by historyMutex
+        mutable std::int64_t openingCents; // balance before the first logged transaction, fixed once the history is loaded
+
+        // history left in a mapped snapshot by attachHistory, copied in by the first access that needs it;
+        // guarded by historyMutex, isHistoryPending is also read lock-free by snapshot()
+        mutable std::span<const TransactionType> pendingTypes;
+        mutable std::span<const std::int64_t> pendingAmounts;
+        mutable std::span<const std::int64_t> pendingTimeStamps;
+        std::int64_t pendingBalanceCents = 0; // the balance the pending history adds up to
+        mutable std::atomic<bool> isHistoryPending{false};
+
+        void touch() const
+        {
+            const std::int64_t now = getEpochSeconds();
+            if (lastAccess.load(std::memory_order_relaxed) != now)
+            {
+                lastAccess.store(now, std::memory_order_relaxed);
+            }
+        }
+
+        // call with historyMutex held: copies in a history attachHistory left in the snapshot
+        void loadPendingLocked() const
+        {
+            if (!isHistoryPending.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            transactions.assign(pendingTypes, pendingAmounts, pendingTimeStamps);
+            openingCents = pendingBalanceCents - transactions.netCents();
+            pendingTypes = {};
+            pendingAmounts = {};
+            pendingTimeStamps = {};
+            isHistoryPending.store(false, std::memory_order_release); // publishes the history && openingCents
+        }
+
+        // call with historyMutex held: expands a compressed (dormant) history before it is used
+        void residentLocked() const
+        {
+            loadPendingLocked();
+            if (transactions.isDormant())
+            {
+                transactions.thaw();
+            }
+        }
+
+        // the history lock for a client access: marks the account as used && its history resident
+        std::unique_lock<std::mutex> lockHistory() const
+        {
+            touch();
+            std::unique_lock lock(historyMutex);
+            residentLocked();
+            return lock;
+        }
+
+        // call with historyMutex held; amount is a withdrawal || an outgoing transfer
+        bool isWithinLimits(Money amount, std::int64_t timeStamp) const
+        {
+            const auto & stats = transactions.stats();
+            Money dayTotal;
+            Money monthTotal;
+            return Money::tryAdd(Money::fromCents(stats.withdrawnOnDayOf(timeStamp)), amount, dayTotal) && dayTotal <= limits.daily &&
+                   Money::tryAdd(Money::fromCents(stats.withdrawnInMonthOf(timeStamp)), amount, monthTotal) && monthTotal <= limits.monthly;
+        }
+
+        // call with historyMutex held so the journal sees each account's operations in history order
+        // returns the journal sequence number to wait on (0 without a journal)
+        std::uint64_t record(TransactionType type, Money amount, std::int64_t timeStamp)
+        {
+            transactions.append(type, amount, timeStamp);
+            if (journal == nullptr)
+            {
+                return 0;
+            }
+            const auto kind = (type == TransactionType::Deposit) ? WalRecordKind::Deposit : WalRecordKind::Withdrawal;
+            journalLsn = journal->append(kind, accountNumber, amount, timeStamp);
+            return journalLsn;
+        }
+
+        // call with historyMutex held, before the operation's first row
+        UndoPoint undoPointLocked() const
+        {
+            return UndoPoint{transactions.size(), journalLsn};
+        }
+
+        // an operation is only reported once it is durable
+        bool waitDurable(std::uint64_t lsn) const
+        {
+            return (journal == nullptr) || journal->waitDurable(lsn);
+        }
+
+        // undoes an operation the journal failed to make durable: its balance change && every row
+        // from its undo point on; a failed journal never makes a later lsn durable, so rows
+        // appended after it belong to operations that fail && roll back their own balance too
+        void rollBack(const UndoPoint & undo, std::int64_t deltaCents)
+        {
+            balance.restore(-deltaCents);
+            const auto lock = lockHistory();
+            transactions.truncate(undo.historyPosition);
+            journalLsn = std::min(journalLsn, undo.journalLsn);
+        }
+
+        static void printTransaction(const Transaction & transactionsIter)
+        {
+            char timeText[formattedTimeLength];
+            std::cout << toString(transactionsIter.type) 
+                      << " of "
+                      << transactionsIter.amount
+                      << " $ "
+                      << "on ";
+            std::cout.write(timeText, formatTime(transactionsIter.timeStamp, timeText) - timeText) 
+                      << "\n";
+        }
 
     public:
-        Account(std::string_view accountNumber, int PIN, double initialBalance) : accountNumber(accountNumber), PIN(PIN), balance(initialBalance) {}
+        Account(std::string_view accountNumber, int PIN, Money initialBalance) : accountNumber(accountNumber), PIN(PIN), balance(initialBalance.getCents()), openingCents(initialBalance.getCents()) {}
 
         bool authenticate(int pinNumber) const 
         {
             return (PIN == pinNumber);
         }
 
-        void deposite(double amount) 
+        std::string_view getAccountNumber() const
+        {
+            return accountNumber;
+        }
+
+        void attachJournal(WriteAheadLog * wal)
+        {
+            journal = wal;
+        }
+
+        // bulk restore from a snapshot, call before the account is shared
+        void loadHistory(std::span<const TransactionType> typeColumn, std::span<const std::int64_t> amountColumn, std::span<const std::int64_t> timeStampColumn)
+        {
+            std::lock_guard lock(historyMutex);
+            transactions.assign(typeColumn, amountColumn, timeStampColumn);
+            openingCents = balance.load() - transactions.netCents();
+        }
+
+        // loadHistory without the copy, for an account materialized under a table lock: the columns stay
+        // where they are (they must outlive the account) && are copied in by the first access to the history,
+        // under this account's lock only; call before the account is shared
+        void attachHistory(std::span<const TransactionType> typeColumn, std::span<const std::int64_t> amountColumn, std::span<const std::int64_t> timeStampColumn)
         {
-            if (amount > 0)
+            std::lock_guard lock(historyMutex);
+            pendingTypes = typeColumn;
+            pendingAmounts = amountColumn;
+            pendingTimeStamps = timeStampColumn;
+            pendingBalanceCents = balance.load();
+            isHistoryPending.store(!typeColumn.empty(), std::memory_order_release);
+        }
+
+        // consistent copy-out point for snapshots: visit(PIN, balance, log, journalLsn) runs under the
+        // history lock; balance is the one the log adds up to (an operation that has moved the balance
+        // but not logged its row yet isn't part of it), journalLsn the last journal record it includes
+        // a dormant log is handed out as is (read it with forEachRow), exporting doesn't expand it
+        template <typename Visitor>
+        void exportState(Visitor visit) const
+        {
+            std::lock_guard lock(historyMutex);
+            loadPendingLocked();
+            visit(PIN, Money::fromCents(openingCents + transactions.netCents()), transactions, journalLsn);
+        }
+
+        // replays one already-validated journal entry: no checks, no output, no journaling
+        // lsn: the journal record it comes from, 0 if it doesn't come from this account's journal
+        void restore(TransactionType type, Money amount, std::int64_t timeStamp, std::uint64_t lsn = 0)
+        {
+            balance.restore(isCredit(type) ? amount.getCents() : -amount.getCents());
+            std::lock_guard lock(historyMutex);
+            residentLocked();
+            transactions.append(type, amount, timeStamp);
+            journalLsn = std::max(journalLsn, lsn);
+        }
+
+        // the last journal record this account includes: later ones still have to be replayed into it
+        std::uint64_t getJournalLsn() const
+        {
+            std::lock_guard lock(historyMutex);
+            return journalLsn;
+        }
+
+        // as exported with the rest of the state, call before the account is shared
+        void setJournalLsn(std::uint64_t lsn)
+        {
+            std::lock_guard lock(historyMutex);
+            journalLsn = lsn;
+        }
+
+        void deposite(Money amount) 
+        {
+            MetricTimer timer(MetricOp::Deposite);
+            std::int64_t newBalance;
+            if (amount <= Money{})
+            {
+                timer.failed();
+                std::cout << "Nice try, jacka$$! \nNext time, give it your A-game!\n";
+            }
+            else if (!balance.tryCredit(amount.getCents(), newBalance))
             {
-                balance += amount;
-                transactions.emplace_back("Deposite", amount);
-                std::cout << "Deposite Successful!\nNew Balance: " 
-                          << balance << " $\n";
+                timer.failed();
+                std::cout << "Deposite Rejected: balance limit reached!\n";
             }
             else 
             {
-                std::cout << "Nice try, jacka$$! \nNext time, give it your A-game!\n";
+                std::uint64_t lsn;
+                UndoPoint undo;
+                {
+                    const auto lock = lockHistory();
+                    undo = undoPointLocked();
+                    lsn = record(TransactionType::Deposit, amount, getEpochSeconds());
+                }
+                if (waitDurable(lsn))
+                {
+                    std::cout << "Deposite Successful!\nNew Balance: " 
+                              << Money::fromCents(newBalance) << " $\n";
+                }
+                else
+                {
+                    rollBack(undo, amount.getCents());
+                    timer.failed();
+                    std::cout << "Deposite Failed: journal write error!\n";
+                }
             }
-                
         }
 
-        bool withdraw(double amount)
+        bool withdraw(Money amount)
         {
-            bool isSuccessfulOperation = true;
-            if (amount > balance)
+            MetricTimer timer(MetricOp::Withdraw);
+            if (amount <= Money{})
             {
-                std::cout << "Insufficient Balance!\n";
-                isSuccessfulOperation = false;
+                // a zero withdrawal would still be journaled && recorded as a transaction
+                timer.failed();
+                std::cout << "Withdrawal Rejected: amount must be positive!\n";
+                return false;
+            }
+
+            std::int64_t newBalance;
+            bool isSuccessfulOperation = balance.tryDebit(amount.getCents(), newBalance);
+
+            if (isSuccessfulOperation)
+            {
+                std::uint64_t lsn;
+                UndoPoint undo;
+                {
+                    auto lock = lockHistory();
+                    const std::int64_t timeStamp = getEpochSeconds();
+                    if (!isWithinLimits(amount, timeStamp))
+                    {
+                        // the overdraft check stays lock-free, so hand back the optimistic debit
+                        balance.restore(amount.getCents());
+                        lock.unlock();
+                        timer.failed();
+                        std::cout << "Withdrawal Rejected: limit exceeded!\n";
+                        return false;
+                    }
+                    undo = undoPointLocked();
+                    lsn = record(TransactionType::Withdrawal, amount, timeStamp);
+                }
+                if (!waitDurable(lsn))
+                {
+                    rollBack(undo, -amount.getCents());
+                    timer.failed();
+                    std::cout << "Withdrawal Failed: journal write error!\n";
+                    return false;
+                }
+            }
+
+            if (isSuccessfulOperation)
+            {
+                std::cout << "Withdrawal Successful!\nRemaining Balance: " << Money::fromCents(newBalance) << " $\n"; 
             }
             else 
             {
-                balance -= amount;
-                std::cout << "Withdrawal Successful!\nRemaining Balance: " << balance << " $\n"; 
+                timer.failed();
+                std::cout << "Insufficient Balance!\n";
             }
 
             return isSuccessfulOperation;
         }
 
-        void showTransactionHistory() const 
+        // settlement path: validates the whole batch first, reserves history once,
+        // then applies every operation in order under a single critical section (no console output)
+        std::vector<OperationResult> applyBatch(std::span<const Operation> operations)
+        {
+            MetricTimer timer(MetricOp::ApplyBatch);
+            PendingBatch batch = beginBatch(operations);
+            // the whole batch shares one group commit
+            std::vector<OperationResult> results = finishBatch(batch, batch.lsn == 0 || waitDurable(batch.lsn));
+            if (std::any_of(results.begin(), results.end(), [](OperationResult result) { return result != OperationResult::Applied; }))
+            {
+                timer.failed();
+            }
+            return results;
+        }
+
+        // first half of applyBatch, for callers that can't block (event loops): applies && journals
+        // the batch; wait for batch.lsn (0: nothing to wait for) then hand the outcome to finishBatch
+        PendingBatch beginBatch(std::span<const Operation> operations)
+        {
+            PendingBatch batch;
+            batch.results.assign(operations.size(), OperationResult::Applied);
+            std::vector<OperationResult> & results = batch.results;
+            std::size_t validCount = 0;
+            for (std::size_t i = 0; i < operations.size(); ++i)
+            {
+                if (operations[i].type != TransactionType::Deposit && operations[i].type != TransactionType::Withdrawal)
+                {
+                    results[i] = OperationResult::UnsupportedType;
+                }
+                else if (operations[i].amount <= Money{})
+                {
+                    results[i] = OperationResult::InvalidAmount;
+                }
+                else
+                {
+                    ++validCount;
+                }
+            }
+
+            const auto lock = lockHistory();
+            transactions.reserveAdditional(validCount);
+            const std::int64_t timeStamp = getEpochSeconds();
+            batch.undo = undoPointLocked();
+
+            for (std::size_t i = 0; i < operations.size(); ++i)
+            {
+                if (results[i] != OperationResult::Applied)
+                {
+                    continue;
+                }
+
+                const Operation & operation = operations[i];
+                std::int64_t newBalance;
+                if (operation.type == TransactionType::Withdrawal && !isWithinLimits(operation.amount, timeStamp))
+                {
+                    results[i] = OperationResult::LimitExceeded;
+                    continue;
+                }
+                if (operation.type == TransactionType::Deposit)
+                {
+                    if (!balance.tryCredit(operation.amount.getCents(), newBalance))
+                    {
+                        results[i] = OperationResult::BalanceOverflow;
+                        continue;
+                    }
+                }
+                else if (!balance.tryDebit(operation.amount.getCents(), newBalance))
+                {
+                    results[i] = OperationResult::InsufficientBalance;
+                    continue;
+                }
+
+                batch.appliedCents += (operation.type == TransactionType::Deposit) ? operation.amount.getCents() : -operation.amount.getCents();
+                batch.lsn = record(operation.type, operation.amount, timeStamp);
+            }
+            return batch;
+        }
+
+        // second half of applyBatch: isDurable says whether batch.lsn made it to the journal,
+        // if not the batch is rolled back && its applied operations report JournalFailure
+        std::vector<OperationResult> finishBatch(PendingBatch & batch, bool isDurable)
+        {
+            if (!isDurable)
+            {
+                rollBack(batch.undo, batch.appliedCents);
+                std::replace(batch.results.begin(), batch.results.end(), OperationResult::Applied, OperationResult::JournalFailure);
+            }
+            return std::move(batch.results);
+        }
+
+        // moves money between accounts as one step: every position's history lock is taken
+        // in the order of the span (callers sort by address, the one global lock order, so
+        // concurrent settlements can't deadlock), then all balances change or none do
+        // positions: distinct accounts, sorted by address, non-zero deltas, sharing one journal;
+        // at most WriteAheadLog::maxSettlementLegs of them, a larger settlement is refused whole
+        static OperationResult applyNetted(std::span<const NetPosition> positions)
+        {
+            if (positions.size() > WriteAheadLog::maxSettlementLegs)
+            {
+                return OperationResult::SettlementTooLarge;
+            }
+
+            std::vector<std::unique_lock<std::mutex>> locks;
+            locks.reserve(positions.size());
+            for (const NetPosition & position : positions)
+            {
+                position.account->touch();
+                locks.emplace_back(position.account->historyMutex);
+                position.account->residentLocked();
+            }
+
+            // debits first: a failing one costs no credit rollback
+            const std::int64_t timeStamp = getEpochSeconds();
+            std::vector<const NetPosition *> applied;
+            applied.reserve(positions.size());
+            OperationResult result = OperationResult::Applied;
+            for (const bool isDebitPass : {true, false})
+            {
+                for (const NetPosition & position : positions)
+                {
+                    if ((position.deltaCents < 0) != isDebitPass || result != OperationResult::Applied)
+                    {
+                        continue;
+                    }
+                    if (isDebitPass && !position.account->isWithinLimits(Money::fromCents(-position.deltaCents), timeStamp))
+                    {
+                        result = OperationResult::LimitExceeded;
+                        continue;
+                    }
+                    std::int64_t newBalance;
+                    if (isDebitPass ? !position.account->balance.tryDebit(-position.deltaCents, newBalance)
+                                    : !position.account->balance.tryCredit(position.deltaCents, newBalance))
+                    {
+                        result = isDebitPass ? OperationResult::InsufficientBalance : OperationResult::BalanceOverflow;
+                        continue;
+                    }
+                    applied.push_back(&position);
+                }
+            }
+            if (result != OperationResult::Applied)
+            {
+                for (const NetPosition * position : applied)
+                {
+                    position->account->balance.restore(-position->deltaCents);
+                }
+                return result;
+            }
+
+            std::vector<WalLeg> legs;
+            std::vector<UndoPoint> undoPoints;
+            legs.reserve(positions.size());
+            undoPoints.reserve(positions.size());
+            for (const NetPosition & position : positions)
+            {
+                undoPoints.push_back(position.account->undoPointLocked());
+                const bool isIncoming = position.deltaCents > 0;
+                const Money amount = Money::fromCents(isIncoming ? position.deltaCents : -position.deltaCents);
+                position.account->transactions.append(isIncoming ? TransactionType::TransferIn : TransactionType::TransferOut, amount, timeStamp);
+                legs.push_back(WalLeg{isIncoming ? WalRecordKind::TransferIn : WalRecordKind::TransferOut, position.account->accountNumber, amount});
+            }
+
+            WriteAheadLog * journal = positions.empty() ? nullptr : positions.front().account->journal;
+            const std::uint64_t lsn = (journal == nullptr) ? 0 : journal->appendSettlement(legs, timeStamp);
+            for (const NetPosition & position : positions)
+            {
+                position.account->journalLsn = std::max(position.account->journalLsn, lsn);
+            }
+            locks.clear();
+
+            if ((journal == nullptr) || (lsn != 0 && journal->waitDurable(lsn)))
+            {
+                return OperationResult::Applied;
+            }
+            // one account at a time: no lock order to respect
+            for (std::size_t i = 0; i < positions.size(); ++i)
+            {
+                positions[i].account->rollBack(undoPoints[i], positions[i].deltaCents);
+            }
+            return OperationResult::JournalFailure;
+        }
+
+        // consistent point-in-time view of the history && the balance it adds up to;
+        // lock-free, so statements of any length never hold up deposits or withdrawals
+        HistorySnapshot snapshot() const
         {
-            std::cout << "Transaction History for Account "
-                      << accountNumber << ":\n";
+            touch();
+            if (isHistoryPending.load(std::memory_order_acquire))
+            {
+                const auto lock = lockHistory();
+                return *transactions.snapshot(openingCents);
+            }
+            if (std::optional<HistorySnapshot> view = transactions.snapshot(openingCents))
+            {
+                return *std::move(view);
+            }
+            const auto lock = lockHistory();
+            return *transactions.snapshot(openingCents);
+        }
 
-            for (const auto & transactionsIter : transactions)
+        // dormant tier: compresses the history of an account untouched for idleSeconds (as of now)
+        // && frees its in-memory copies; the next access expands it again. true if it was compressed
+        bool compressIfIdle(std::int64_t now, std::int64_t idleSeconds)
+        {
+            if (now - lastAccess.load(std::memory_order_relaxed) < idleSeconds)
             {
-                std::cout << transactionsIter.type 
-                          << " of "
-                          << transactionsIter.amount
-                          << " $ "
-                          << "on "
-                          << transactionsIter.timeStamp 
-                          << "\n";
+                return false;
             }
+            std::lock_guard lock(historyMutex);
+            return (now - lastAccess.load(std::memory_order_relaxed) >= idleSeconds) && transactions.freeze();
         }
 
-        void sortTransactionsByAmount()
+        bool isDormant() const
         {
-            std::sort(transactions.begin(), transactions.end(), [](const Transaction & a, const Transaction & b)
-                { return a.amount < b.amount; } // sort ascendingly
-            );
+            std::lock_guard lock(historyMutex);
+            return transactions.isDormant();
+        }
+
+        // appends the current history to writer in the compact binary format (see TransactionCodec.hpp), lock-free
+        void exportHistory(TransactionWriter & writer) const
+        {
+            const HistorySnapshot history = snapshot();
+            writer.reserve(history.size());
+            for (std::size_t i = 0; i < history.size(); ++i)
+            {
+                writer.append(history[i]);
+            }
+        }
+
+        // formats one page of the current history into renderer, without taking the history lock
+        HistoryPage renderHistory(HistoryRenderer & renderer, const PageRequest & request) const
+        {
+            MetricTimer timer(MetricOp::RenderHistory);
+            return renderer.appendPage(snapshot(), request);
+        }
+
+        // every page comes from the same snapshot, so concurrent writes never split the statement
+        // false if a page can't be written to fd, the rest of the statement is dropped then
+        bool showTransactionHistory(int fd = STDOUT_FILENO) const
+        {
+            HistoryRenderer renderer;
+            renderer.appendText("Transaction History for Account ");
+            renderer.appendText(accountNumber);
+            renderer.appendText(":\n");
+
+            const HistorySnapshot history = snapshot();
+            std::cout.flush(); // keep ordering with earlier std::cout output
+            PageRequest request;
+            HistoryPage page;
+            do
+            {
+                {
+                    MetricTimer timer(MetricOp::RenderHistory);
+                    page = renderer.appendPage(history, request);
+                }
+                if (!renderer.flush(fd))
+                {
+                    std::cerr << "History Failed: output write error!\n";
+                    return false;
+                }
+                request.offset = page.nextOffset;
+            } while (page.hasMore());
+            return true;
+        }
+
+        // lists the history ascending by amount through the amount index,
+        // the log itself keeps its chronological order
+        void sortTransactionsByAmount() const
+        {
+            MetricTimer timer(MetricOp::SortByAmount);
+            std::vector<Transaction> sorted;
+            {
+                const auto lock = lockHistory();
+                sorted = transactions.sortedByAmount();
+            }
 
             std::cout << "Transactions sorted ascendingly by amount\n";
+            for (const auto & transactionsIter : sorted)
+            {
+                printTransaction(transactionsIter);
+            }
+        }
+
+        std::vector<Transaction> largestTransactions(TransactionType type, std::size_t k) const
+        {
+            const auto lock = lockHistory();
+            return transactions.largest(type, k);
+        }
+
+        std::vector<Transaction> transactionsInAmountRange(TransactionType type, Money low, Money high) const
+        {
+            const auto lock = lockHistory();
+            return transactions.inAmountRange(type, low, high);
+        }
+
+        // statements && disputes: visit(range) gets a no-copy view of every transaction
+        // with from <= timeStamp <= to; the view is only valid inside visit (history lock held)
+        template <typename Visitor>
+        decltype(auto) withTransactionsBetween(std::int64_t from, std::int64_t to, Visitor visit) const
+        {
+            const auto lock = lockHistory();
+            return visit(transactions.between(from, to));
+        }
+
+        void setWithdrawalLimits(WithdrawalLimits newLimits)
+        {
+            std::lock_guard lock(historyMutex);
+            limits = newLimits;
+        }
+
+        WithdrawalLimits getWithdrawalLimits() const
+        {
+            std::lock_guard lock(historyMutex);
+            return limits;
+        }
+
+        // snapshot of the running aggregates (totals, min/max, counts, day && month withdrawals)
+        AccountStats<transactionTypeCount> getStats() const
+        {
+            std::lock_guard lock(historyMutex);
+            loadPendingLocked();
+            return transactions.stats();
+        }
+
+        Money withdrawnToday() const
+        {
+            std::lock_guard lock(historyMutex);
+            loadPendingLocked();
+            return Money::fromCents(transactions.stats().withdrawnOnDayOf(getEpochSeconds()));
+        }
+
+        Money getTotal(TransactionType type) const
+        {
+            std::lock_guard lock(historyMutex);
+            loadPendingLocked();
+            return transactions.total(type);
+        }
+
+        Money getBalance() const
+        {
+            return Money::fromCents(balance.load());
         }
 
         void displayBalance() const 
         {
             std::cout << "Current Balance: "
-                      << balance
+                      << getBalance()
                       << " $\n";
         }
 };
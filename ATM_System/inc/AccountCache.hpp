@@ -0,0 +1,475 @@
+#pragma once
+
+#include <atomic> // pins, reference bits, counters
+#include <memory> // resident accounts
+#include <shared_mutex> // hits (shared) vs loads && evictions (exclusive)
+#include <condition_variable> // waiting for an account another thread is loading
+#include <string> // entry keys, journal path
+#include <vector> // free entries, flush list
+#include <string_view> // lightweight string lib
+#include <utility> // exchange
+#include <algorithm> // max
+#include <cstdint> // counters
+#include <cstddef> // size_t
+#include "Account.hpp"
+#include "AccountIndex.hpp"
+#include "AccountStore.hpp"
+#include "Metrics.hpp"
+
+enum class AccessMode : std::uint8_t
+{
+    Read, // balance, history
+    Write // anything that changes the account: it is written back before eviction
+};
+
+// hit rate && eviction counters of an AccountCache
+struct CacheStats
+{
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0; // loads from the store, unknown accounts included
+    std::uint64_t evictions = 0;
+    std::uint64_t writeBacks = 0; // dirty accounts saved, on eviction or flush
+    std::size_t resident = 0;
+    std::size_t capacity = 0;
+
+    double hitRate() const
+    {
+        const std::uint64_t lookups = hits + misses;
+        return (lookups == 0) ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+};
+
+struct CacheEntry
+{
+    std::string accountNumber; // index key, also while the account is being loaded
+    std::unique_ptr<Account> account; // nullptr while the entry is free or loading
+    bool isLoading = false; // guarded by the cache lock, waiters sleep on the cache's condition variable
+    std::atomic<std::uint32_t> pins{0}; // live leases (+ the loader or writer-back), only ever raised under the cache lock
+    std::atomic<bool> isReferenced{false}; // CLOCK's second-chance bit
+    std::atomic<bool> isDirty{false};
+};
+
+// keeps an account resident (pinned) while it is held; move-only
+// also hands out accounts that are never evicted (an ATM without a store), with nothing to pin
+class AccountLease
+{
+    private:
+        CacheEntry * entry = nullptr; // nullptr: nothing pinned
+        Account * account = nullptr;
+
+    public:
+        AccountLease() = default;
+        explicit AccountLease(CacheEntry * pinned) : entry(pinned), account(pinned->account.get()) {}
+        explicit AccountLease(Account * resident) : account(resident) {}
+
+        AccountLease(AccountLease && other) noexcept : entry(std::exchange(other.entry, nullptr)), account(std::exchange(other.account, nullptr)) {}
+
+        AccountLease & operator=(AccountLease && other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                entry = std::exchange(other.entry, nullptr);
+                account = std::exchange(other.account, nullptr);
+            }
+            return *this;
+        }
+
+        ~AccountLease()
+        {
+            release();
+        }
+
+        void release()
+        {
+            if (entry != nullptr)
+            {
+                entry->pins.fetch_sub(1, std::memory_order_release);
+                entry = nullptr;
+            }
+            account = nullptr;
+        }
+
+        explicit operator bool() const
+        {
+            return account != nullptr;
+        }
+
+        // valid while the lease is held
+        Account * get() const
+        {
+            return account;
+        }
+
+        Account * operator->() const
+        {
+            return account;
+        }
+
+        Account & operator*() const
+        {
+            return *account;
+        }
+};
+
+// bounded set of resident accounts in front of an AccountStore, for populations that don't fit in memory
+// eviction is CLOCK (second chance): every hit sets the entry's reference bit, the hand clears bits until
+// it reaches an unreferenced, unpinned entry; a dirty victim is written back before it is dropped
+// hits only take the table lock shared; store reads && writes run outside it: a loading entry is
+// already indexed (concurrent misses on it wait instead of loading twice) && a victim being written
+// back stays pinned, so no other lookup is held up by the disk
+// with a journal, every change made through a lease is journaled (&& durable) before it is reported,
+// as for resident accounts; the store is a write-back cache of the journal: recover() brings it up to date
+// used standalone || as the account table of an ATM built on a store
+class AccountCache
+{
+    private:
+        AccountStore & store;
+        WriteAheadLog * journal;
+        std::unique_ptr<CacheEntry[]> entries;
+        std::size_t capacity;
+        std::size_t used = 0; // entries below used have held an account
+        std::vector<std::size_t> freeEntries; // below used, holding nothing (a load that found no account)
+        std::size_t hand = 0;
+        AccountIndex index; // account number -> entry
+        mutable std::shared_mutex tableMutex;
+        std::condition_variable_any loadFinished; // wakes lookups that found their account loading
+
+        std::atomic<std::uint64_t> hits{0};
+        std::atomic<std::uint64_t> misses{0};
+        std::atomic<std::uint64_t> evictions{0};
+        std::atomic<std::uint64_t> writeBacks{0};
+
+        auto keyAt() const
+        {
+            return [this](std::size_t position) { return std::string_view(entries[position].accountNumber); };
+        }
+
+        // call with tableMutex held (shared is enough)
+        AccountLease pin(std::size_t position, AccessMode mode)
+        {
+            CacheEntry & entry = entries[position];
+            entry.pins.fetch_add(1, std::memory_order_acquire);
+            if (!entry.isReferenced.load(std::memory_order_relaxed))
+            {
+                entry.isReferenced.store(true, std::memory_order_relaxed);
+            }
+            if (mode == AccessMode::Write && !entry.isDirty.load(std::memory_order_relaxed))
+            {
+                entry.isDirty.store(true, std::memory_order_relaxed);
+            }
+            return AccountLease(&entry);
+        }
+
+        // call with lock (tableMutex, exclusive) held: a free entry, evicting the CLOCK victim if needed;
+        // a dirty victim is written back with the lock released. npos if every entry stayed pinned
+        // (or failed to write back) for two full turns of the hand with the lock held
+        std::size_t claimEntry(std::unique_lock<std::shared_mutex> & lock)
+        {
+            if (!freeEntries.empty())
+            {
+                const std::size_t position = freeEntries.back();
+                freeEntries.pop_back();
+                return position;
+            }
+            if (used < capacity)
+            {
+                return used++;
+            }
+
+            for (std::size_t step = 0; step < 2 * capacity; ++step)
+            {
+                const std::size_t position = hand;
+                hand = (hand + 1 == capacity) ? 0 : hand + 1;
+                CacheEntry & candidate = entries[position];
+                if (candidate.account == nullptr || candidate.pins.load(std::memory_order_acquire) != 0 ||
+                    candidate.isReferenced.exchange(false, std::memory_order_relaxed))
+                {
+                    continue;
+                }
+
+                MetricTimer timer(MetricOp::EvictAccount);
+                if (candidate.isDirty.load(std::memory_order_relaxed))
+                {
+                    // pinned: nobody evicts it meanwhile; a write lease taken meanwhile marks it dirty again
+                    candidate.pins.fetch_add(1, std::memory_order_acquire);
+                    candidate.isDirty.store(false, std::memory_order_relaxed);
+                    lock.unlock();
+                    const bool isSaved = store.save(*candidate.account);
+                    lock.lock();
+                    candidate.pins.fetch_sub(1, std::memory_order_release);
+                    if (!isSaved)
+                    {
+                        candidate.isDirty.store(true, std::memory_order_relaxed);
+                        timer.failed();
+                        continue; // never drop changes that aren't on disk
+                    }
+                    writeBacks.fetch_add(1, std::memory_order_relaxed);
+                    step = 0; // the table may have changed while it was unlocked, look again
+                    if (candidate.pins.load(std::memory_order_acquire) != 0 || candidate.isDirty.load(std::memory_order_relaxed) ||
+                        candidate.isReferenced.load(std::memory_order_relaxed))
+                    {
+                        continue; // used again while it was written back, it stays
+                    }
+                }
+                index.erase(candidate.accountNumber, keyAt());
+                candidate.account.reset();
+                evictions.fetch_add(1, std::memory_order_relaxed);
+                return position;
+            }
+            return AccountIndex::npos;
+        }
+
+    public:
+        // capacity: resident accounts at most (at least 1); journal: optional, see the class comment
+        AccountCache(AccountStore & accountStore, std::size_t capacity, WriteAheadLog * wal = nullptr) : store(accountStore), journal(wal), entries(new CacheEntry[std::max<std::size_t>(capacity, 1)]), capacity(std::max<std::size_t>(capacity, 1))
+        {
+            index.reserve(this->capacity);
+        }
+
+        // writes every change back
+        ~AccountCache()
+        {
+            flush();
+        }
+
+        AccountCache(const AccountCache &) = delete;
+        AccountCache & operator=(const AccountCache &) = delete;
+
+        // from now on every change made through a lease is journaled; call before serving
+        void attachJournal(WriteAheadLog * wal)
+        {
+            std::unique_lock lock(tableMutex);
+            journal = wal;
+            for (std::size_t position = 0; position < used; ++position)
+            {
+                if (entries[position].account != nullptr)
+                {
+                    entries[position].account->attachJournal(journal);
+                }
+            }
+        }
+
+        // resident account, loaded from the store on a miss; empty if the account is unknown
+        // or every entry is pinned; write leases mark the account for write-back
+        AccountLease acquire(std::string_view accountNumber, AccessMode mode)
+        {
+            {
+                std::shared_lock lock(tableMutex);
+                const std::size_t position = index.find(accountNumber, keyAt());
+                if (position != AccountIndex::npos && !entries[position].isLoading)
+                {
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    return pin(position, mode);
+                }
+            }
+
+            MetricTimer timer(MetricOp::LoadAccount);
+            std::unique_lock lock(tableMutex);
+            std::size_t claimed = AccountIndex::npos;
+            while (true)
+            {
+                const std::size_t position = index.find(accountNumber, keyAt());
+                if (position != AccountIndex::npos && entries[position].isLoading)
+                {
+                    loadFinished.wait(lock); // another thread is loading it
+                    continue;
+                }
+                if (position != AccountIndex::npos)
+                {
+                    // loaded meanwhile, possibly while claimEntry had the lock released
+                    if (claimed != AccountIndex::npos)
+                    {
+                        freeEntries.push_back(claimed);
+                    }
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    return pin(position, mode);
+                }
+                if (claimed != AccountIndex::npos)
+                {
+                    break;
+                }
+                claimed = claimEntry(lock);
+                if (claimed == AccountIndex::npos)
+                {
+                    timer.failed();
+                    return AccountLease();
+                }
+            }
+
+            // indexed while loading, pinned by the loader (the pin becomes the returned lease)
+            misses.fetch_add(1, std::memory_order_relaxed);
+            CacheEntry & entry = entries[claimed];
+            entry.accountNumber.assign(accountNumber);
+            entry.isLoading = true;
+            entry.pins.store(1, std::memory_order_relaxed);
+            entry.isReferenced.store(true, std::memory_order_relaxed);
+            entry.isDirty.store(mode == AccessMode::Write, std::memory_order_relaxed);
+            index.insert(entry.accountNumber, claimed, keyAt());
+            lock.unlock();
+
+            std::unique_ptr<Account> loaded = store.load(accountNumber);
+            if (loaded != nullptr)
+            {
+                loaded->attachJournal(journal);
+            }
+
+            lock.lock();
+            entry.isLoading = false;
+            loadFinished.notify_all();
+            if (loaded == nullptr)
+            {
+                index.erase(entry.accountNumber, keyAt());
+                entry.pins.store(0, std::memory_order_relaxed);
+                freeEntries.push_back(claimed);
+                timer.failed();
+                return AccountLease();
+            }
+            entry.account = std::move(loaded);
+            return AccountLease(&entry);
+        }
+
+        // a read lease on the account if it is resident right now, empty otherwise: nothing is loaded,
+        // evicted || counted, for sweeps that must not push the working set out
+        AccountLease peek(std::string_view accountNumber)
+        {
+            std::shared_lock lock(tableMutex);
+            const std::size_t position = index.find(accountNumber, keyAt());
+            if (position == AccountIndex::npos || entries[position].isLoading)
+            {
+                return AccountLease();
+            }
+            entries[position].pins.fetch_add(1, std::memory_order_acquire);
+            return AccountLease(&entries[position]);
+        }
+
+        // visit(Account &) for every resident account, each pinned for the sweep && visited outside the table lock;
+        // visits that change an account must not rely on it being written back
+        template <typename Visitor>
+        void forEachResident(Visitor visit)
+        {
+            std::vector<AccountLease> resident;
+            {
+                std::shared_lock lock(tableMutex);
+                resident.reserve(used);
+                for (std::size_t position = 0; position < used; ++position)
+                {
+                    CacheEntry & entry = entries[position];
+                    if (entry.account != nullptr && !entry.isLoading)
+                    {
+                        entry.pins.fetch_add(1, std::memory_order_acquire);
+                        resident.emplace_back(&entry);
+                    }
+                }
+            }
+            for (const AccountLease & lease : resident)
+            {
+                visit(*lease);
+            }
+        }
+
+        // new accounts go straight to the store (journaled first, if there is a journal),
+        // they become resident on first use
+        bool addAccount(std::string_view accountNumber, int PIN, Money initialBalance)
+        {
+            if (store.contains(accountNumber))
+            {
+                return false;
+            }
+            Account account(accountNumber, PIN, initialBalance);
+            if (journal != nullptr)
+            {
+                const std::uint64_t lsn = journal->append(WalRecordKind::OpenAccount, accountNumber, initialBalance, getEpochSeconds(), PIN);
+                if (!journal->waitDurable(lsn))
+                {
+                    return false;
+                }
+                account.setJournalLsn(lsn);
+            }
+            return store.add(account);
+        }
+
+        // brings the store up to date after a crash: re-applies every record of the journal at path that
+        // an account's stored copy doesn't include yet (accounts whose opening never reached the store
+        // are added), then flushes; call before serving. returns the number of records applied
+        std::size_t recover(const std::string & path)
+        {
+            std::size_t applied = 0;
+            WriteAheadLog::replay(path, [&](const WalRecord & record)
+            {
+                if (record.kind == WalRecordKind::OpenAccount)
+                {
+                    if (!store.contains(record.accountNumber))
+                    {
+                        Account account(record.accountNumber, record.pin, record.amount);
+                        account.setJournalLsn(record.lsn);
+                        applied += store.add(account) ? 1 : 0;
+                    }
+                    return;
+                }
+
+                const AccountLease lease = acquire(record.accountNumber, AccessMode::Write);
+                if (lease && lease->getJournalLsn() < record.lsn)
+                {
+                    lease->restore(transactionTypeOf(record.kind), record.amount, record.timeStamp, record.lsn);
+                    ++applied;
+                }
+            });
+            flush();
+            return applied;
+        }
+
+        // writes back every dirty account (outside the table lock) && syncs the store;
+        // pinned ones stay dirty, their holder may still be changing them
+        bool flush()
+        {
+            std::vector<std::size_t> dirty;
+            {
+                std::unique_lock lock(tableMutex);
+                for (std::size_t position = 0; position < used; ++position)
+                {
+                    CacheEntry & entry = entries[position];
+                    if (entry.account == nullptr || !entry.isDirty.load(std::memory_order_relaxed))
+                    {
+                        continue;
+                    }
+                    const bool isHeld = entry.pins.fetch_add(1, std::memory_order_acquire) != 0;
+                    if (!isHeld)
+                    {
+                        entry.isDirty.store(false, std::memory_order_relaxed);
+                    }
+                    dirty.push_back(position);
+                }
+            }
+
+            bool isSaved = true;
+            for (const std::size_t position : dirty)
+            {
+                CacheEntry & entry = entries[position];
+                if (store.save(*entry.account))
+                {
+                    writeBacks.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    entry.isDirty.store(true, std::memory_order_relaxed);
+                    isSaved = false;
+                }
+                entry.pins.fetch_sub(1, std::memory_order_release);
+            }
+            return store.sync() && isSaved;
+        }
+
+        CacheStats stats() const
+        {
+            CacheStats snapshot;
+            snapshot.hits = hits.load(std::memory_order_relaxed);
+            snapshot.misses = misses.load(std::memory_order_relaxed);
+            snapshot.evictions = evictions.load(std::memory_order_relaxed);
+            snapshot.writeBacks = writeBacks.load(std::memory_order_relaxed);
+            snapshot.capacity = capacity;
+            std::shared_lock lock(tableMutex);
+            snapshot.resident = used - freeEntries.size();
+            return snapshot;
+        }
+};
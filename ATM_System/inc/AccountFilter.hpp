@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic> // lock-free membership checks
+#include <memory> // word storage
+#include <cstdint> // fixed width hashes
+#include <cstddef> // size_t
+
+// split-block Bloom filter over account numbers (by their hashAccountNumber value):
+// a key owns one 64-byte block && sets one bit in each of its 8 words,
+// so a lookup is a single cache line && "definitely absent" needs no table access
+// ~16 bits per key keeps false positives well below 1%; no false negatives
+//
+// insert must be serialized by the caller, mayContain is lock-free && may run concurrently
+class AccountFilter
+{
+    private:
+        static constexpr std::size_t wordsPerBlock = 8;
+        static constexpr std::size_t bitsPerKey = 16;
+
+        std::unique_ptr<std::atomic<std::uint64_t>[]> words;
+        std::size_t blockMask;
+        std::size_t keyCapacity;
+
+        // spreads FNV output: its low bits already pick the AccountIndex slot
+        static std::uint64_t remix(std::uint64_t hash)
+        {
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        // one bit per word, from 6-bit slices of an odd multiply (as in Parquet's filter)
+        static std::uint64_t bitFor(std::uint32_t key, std::size_t word)
+        {
+            constexpr std::uint32_t salts[wordsPerBlock] = {
+                0x47B6137BU, 0x44974D91U, 0x8824AD5BU, 0xA2B7289DU,
+                0x705495C7U, 0x2DF1424BU, 0x9EFC4947U, 0x5C6BFB31U
+            };
+            return std::uint64_t{1} << ((key * salts[word]) >> 26);
+        }
+
+    public:
+        explicit AccountFilter(std::size_t expectedKeys)
+        {
+            std::size_t blocks = 1;
+            while (blocks * wordsPerBlock * 64 < expectedKeys * bitsPerKey)
+            {
+                blocks *= 2;
+            }
+            words.reset(new std::atomic<std::uint64_t>[blocks * wordsPerBlock]());
+            blockMask = blocks - 1;
+            keyCapacity = blocks * wordsPerBlock * 64 / bitsPerKey;
+        }
+
+        // keys it can hold before the false-positive rate climbs
+        std::size_t capacity() const
+        {
+            return keyCapacity;
+        }
+
+        void insert(std::uint64_t hash)
+        {
+            hash = remix(hash);
+            std::atomic<std::uint64_t> * block = &words[((hash >> 32) & blockMask) * wordsPerBlock];
+            for (std::size_t word = 0; word < wordsPerBlock; ++word)
+            {
+                block[word].fetch_or(bitFor(static_cast<std::uint32_t>(hash), word), std::memory_order_relaxed);
+            }
+        }
+
+        bool mayContain(std::uint64_t hash) const
+        {
+            hash = remix(hash);
+            const std::atomic<std::uint64_t> * block = &words[((hash >> 32) & blockMask) * wordsPerBlock];
+            std::uint64_t missing = 0;
+            for (std::size_t word = 0; word < wordsPerBlock; ++word)
+            {
+                const std::uint64_t bit = bitFor(static_cast<std::uint32_t>(hash), word);
+                missing |= bit & ~block[word].load(std::memory_order_relaxed);
+            }
+            return missing == 0;
+        }
+};
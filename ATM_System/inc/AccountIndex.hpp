@@ -0,0 +1,156 @@
+#pragma once
+
+#include <vector> // slot table
+#include <cstdint> // fixed width hashes
+#include <cstddef> // size_t
+#include <string_view> // lightweight string lib
+
+// FNV-1a: stable across runs && platforms (unlike std::hash)
+inline std::uint64_t hashAccountNumber(std::string_view accountNumber)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (const char c : accountNumber)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// open-addressing (linear probing) index: account number -> position
+// the index only keeps hashes && positions, keys are read back through keyAt(position)
+class AccountIndex
+{
+    private:
+        struct Slot
+        {
+            std::uint64_t hash;
+            std::size_t position; // npos marks an empty slot
+        };
+
+        std::vector<Slot> slots;
+        std::size_t count = 0;
+
+        std::size_t mask() const
+        {
+            return slots.size() - 1;
+        }
+
+        // keep load factor <= 1/2 so probe chains stay short
+        void grow()
+        {
+            std::vector<Slot> old(slots.empty() ? 16 : slots.size() * 2, Slot{0, npos});
+            old.swap(slots);
+
+            for (const auto & slotIter : old)
+            {
+                if (slotIter.position != npos)
+                {
+                    std::size_t i = slotIter.hash & mask();
+                    while (slots[i].position != npos)
+                    {
+                        i = (i + 1) & mask();
+                    }
+                    slots[i] = slotIter;
+                }
+            }
+        }
+
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        void reserve(std::size_t expectedCount)
+        {
+            while (slots.size() < expectedCount * 2)
+            {
+                grow();
+            }
+        }
+
+        std::size_t size() const
+        {
+            return count;
+        }
+
+        template <typename KeyAt>
+        std::size_t find(std::string_view key, KeyAt keyAt) const
+        {
+            if (slots.empty())
+            {
+                return npos;
+            }
+
+            const std::uint64_t hash = hashAccountNumber(key);
+            for (std::size_t i = hash & mask(); slots[i].position != npos; i = (i + 1) & mask())
+            {
+                if (slots[i].hash == hash && keyAt(slots[i].position) == key)
+                {
+                    return slots[i].position;
+                }
+            }
+
+            return npos;
+        }
+
+        // returns false (&& keeps the old entry) if key is already indexed
+        template <typename KeyAt>
+        bool insert(std::string_view key, std::size_t position, KeyAt keyAt)
+        {
+            if ((count + 1) * 2 > slots.size())
+            {
+                grow();
+            }
+
+            const std::uint64_t hash = hashAccountNumber(key);
+            std::size_t i = hash & mask();
+            while (slots[i].position != npos)
+            {
+                if (slots[i].hash == hash && keyAt(slots[i].position) == key)
+                {
+                    return false;
+                }
+                i = (i + 1) & mask();
+            }
+
+            slots[i] = Slot{hash, position};
+            ++count;
+            return true;
+        }
+
+        // backward-shift deletion: later entries of the probe chain move up, so no tombstones are left
+        // returns false if key isn't indexed
+        template <typename KeyAt>
+        bool erase(std::string_view key, KeyAt keyAt)
+        {
+            if (slots.empty())
+            {
+                return false;
+            }
+
+            const std::uint64_t hash = hashAccountNumber(key);
+            std::size_t hole = hash & mask();
+            while (slots[hole].position != npos && !(slots[hole].hash == hash && keyAt(slots[hole].position) == key))
+            {
+                hole = (hole + 1) & mask();
+            }
+            if (slots[hole].position == npos)
+            {
+                return false;
+            }
+
+            slots[hole].position = npos;
+            --count;
+            for (std::size_t i = (hole + 1) & mask(); slots[i].position != npos; i = (i + 1) & mask())
+            {
+                // an entry may only fill the hole if its home slot isn't between the hole && itself
+                const std::size_t home = slots[i].hash & mask();
+                if (((i - home) & mask()) >= ((i - hole) & mask()))
+                {
+                    slots[hole] = slots[i];
+                    slots[i].position = npos;
+                    hole = i;
+                }
+            }
+            return true;
+        }
+};
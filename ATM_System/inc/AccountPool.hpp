@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic> // lock-free handle resolution
+#include <memory> // slab directory
+#include <vector> // free list
+#include <cstdint> // slot / generation
+#include <cstddef> // std::byte
+#include <new> // placement new
+#include <utility> // forward
+#include "Account.hpp"
+
+// cheap reference to a pooled account: resolving it is two loads, no refcount
+// a handle to a released slot stays detectably stale, even after the slot is reused
+struct AccountHandle
+{
+    std::uint32_t slot = 0;
+    std::uint32_t generation = 0; // live generations are odd, so 0 never resolves
+
+    explicit operator bool() const
+    {
+        return generation != 0;
+    }
+
+    bool operator==(const AccountHandle &) const = default;
+};
+
+// accounts live contiguously in fixed-size slabs that never move,
+// so iteration is a linear walk && a resolved Account * stays valid until its slot is released
+//
+// emplace / release must be serialized by the caller (ATM holds its table lock exclusively),
+// get() is lock-free && may run concurrently with both
+class AccountPool
+{
+    private:
+        static constexpr std::size_t slabSize = 1024; // accounts per slab
+        static constexpr std::size_t maxSlabs = 1 << 16; // 64M accounts
+
+        struct Slot
+        {
+            alignas(Account) std::byte storage[sizeof(Account)];
+            std::atomic<std::uint32_t> generation{0}; // odd = live, bumped on every emplace && release
+
+            Account * account()
+            {
+                return std::launder(reinterpret_cast<Account *>(storage));
+            }
+        };
+
+        struct Slab
+        {
+            Slot slots[slabSize];
+        };
+
+        std::unique_ptr<std::atomic<Slab *>[]> slabs;
+        std::uint32_t slotCount = 0; // high-water mark
+        std::vector<std::uint32_t> freeSlots;
+
+        Slot & slotAt(std::uint32_t slot) const
+        {
+            return slabs[slot / slabSize].load(std::memory_order_acquire)->slots[slot % slabSize];
+        }
+
+    public:
+        AccountPool() : slabs(new std::atomic<Slab *>[maxSlabs]())
+        {
+        }
+
+        ~AccountPool()
+        {
+            forEach([](AccountHandle, Account & account) { account.~Account(); });
+            for (std::size_t i = 0; i * slabSize < slotCount; ++i)
+            {
+                delete slabs[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        AccountPool(const AccountPool &) = delete;
+        AccountPool & operator=(const AccountPool &) = delete;
+
+        // reuses the most recently released slot, otherwise appends (one allocation per slab, not per account)
+        // returns an empty handle (nothing constructed) once the pool is full
+        template <typename... Args>
+        AccountHandle emplace(Args &&... args)
+        {
+            if (isFull())
+            {
+                return AccountHandle{};
+            }
+
+            std::uint32_t slot;
+            if (!freeSlots.empty())
+            {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else
+            {
+                slot = slotCount++;
+                if (slot % slabSize == 0)
+                {
+                    slabs[slot / slabSize].store(new Slab(), std::memory_order_release);
+                }
+            }
+
+            Slot & target = slotAt(slot);
+            new (target.storage) Account(std::forward<Args>(args)...);
+            const std::uint32_t generation = target.generation.load(std::memory_order_relaxed) + 1;
+            target.generation.store(generation, std::memory_order_release);
+            return AccountHandle{slot, generation};
+        }
+
+        // destroys the account, every outstanding handle to it becomes stale
+        void release(AccountHandle handle)
+        {
+            if (get(handle) == nullptr)
+            {
+                return;
+            }
+            Slot & target = slotAt(handle.slot);
+            target.generation.store(handle.generation + 1, std::memory_order_release);
+            target.account()->~Account();
+            freeSlots.push_back(handle.slot);
+        }
+
+        // nullptr if the handle is stale or was never valid
+        Account * get(AccountHandle handle) const
+        {
+            if (handle.slot >= maxSlabs * slabSize)
+            {
+                return nullptr;
+            }
+            Slab * slab = slabs[handle.slot / slabSize].load(std::memory_order_acquire);
+            if (slab == nullptr)
+            {
+                return nullptr;
+            }
+            Slot & target = slab->slots[handle.slot % slabSize];
+            return (handle.generation != 0 && target.generation.load(std::memory_order_acquire) == handle.generation) ? target.account() : nullptr;
+        }
+
+        // slot must be live (e.g. one found through the account index)
+        Account & at(std::uint32_t slot) const
+        {
+            return *slotAt(slot).account();
+        }
+
+        AccountHandle handleAt(std::uint32_t slot) const
+        {
+            return AccountHandle{slot, slotAt(slot).generation.load(std::memory_order_acquire)};
+        }
+
+        std::size_t size() const
+        {
+            return slotCount - freeSlots.size();
+        }
+
+        // every slot of every slab is live
+        bool isFull() const
+        {
+            return freeSlots.empty() && slotCount == maxSlabs * slabSize;
+        }
+
+        // visit(handle, account) for every live account, in memory order
+        template <typename Visitor>
+        void forEach(Visitor visit) const
+        {
+            for (std::uint32_t slot = 0; slot < slotCount; ++slot)
+            {
+                Slot & target = slotAt(slot);
+                const std::uint32_t generation = target.generation.load(std::memory_order_acquire);
+                if (generation & 1U)
+                {
+                    visit(AccountHandle{slot, generation}, *target.account());
+                }
+            }
+        }
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <string> // file path
+#include <string_view> // lightweight string lib
+#include <cstdint> // fixed width on-disk layout
+#include <memory> // unique_ptr factory
+#include <span> // in-place column views
+#include <chrono> // background interval
+#include <thread> // jthread
+#include <condition_variable> // interruptible wait
+#include <mutex> // wait mutex
+#include "Money.hpp"
+#include "Transactions.hpp"
+
+class ATM;
+
+// on-disk snapshot layout, every section 8-byte aligned:
+// [SnapshotHeader][SnapshotAccount x accountCount][u64 index x indexCapacity]
+// [i64 amounts x transactionCount][i64 timeStamps x transactionCount][u8 types x transactionCount]
+struct SnapshotHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t accountCount;
+    std::uint64_t indexCapacity; // power of two, slots hold position + 1 (0 = empty)
+    std::uint64_t transactionCount;
+    std::uint64_t journalLsn; // every journal record up to this one is included (0: none / no journal)
+};
+
+struct SnapshotAccount
+{
+    static constexpr std::size_t maxNumberLength = 24;
+
+    char number[maxNumberLength];
+    std::uint8_t numberLength;
+    std::uint8_t padding[3];
+    std::int32_t pin;
+    std::int64_t balanceCents;
+    std::uint64_t firstTransaction; // into the transaction columns
+    std::uint64_t transactionCount;
+    std::uint64_t journalLsn; // last journal record included, can be past the header's (changed while copied)
+
+    std::string_view getAccountNumber() const
+    {
+        return std::string_view(number, numberLength);
+    }
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0 && sizeof(SnapshotAccount) % 8 == 0, "snapshot sections must stay 8-byte aligned");
+
+// read-only account table mapped straight from a snapshot file:
+// loading costs one mmap, records are used in place && only touched pages are read,
+// so each record is checked when it is first used (find / at), not when the file is loaded
+class AccountSnapshot
+{
+    private:
+        void * mapping = nullptr;
+        std::size_t mappingSize = 0;
+
+        const SnapshotHeader * header = nullptr;
+        const SnapshotAccount * accounts = nullptr;
+        const std::uint64_t * index = nullptr;
+        const std::int64_t * amounts = nullptr;
+        const std::int64_t * timeStamps = nullptr;
+        const TransactionType * types = nullptr;
+
+        AccountSnapshot() = default;
+
+        // write, also reporting the journal lsn the file covers
+        static bool writeCovering(const std::string & path, const ATM & atm, std::uint64_t & coveredLsn);
+
+        // the record's number fits its field, its transaction range && type bytes stay inside the columns
+        bool isIntact(const SnapshotAccount & account) const;
+
+        // one probe sequence over the mapped index, the record found is only checked as far as its number
+        const SnapshotAccount * probe(std::string_view accountNumber) const;
+
+    public:
+        static constexpr std::uint32_t formatVersion = 2;
+
+        ~AccountSnapshot();
+        AccountSnapshot(const AccountSnapshot &) = delete;
+        AccountSnapshot & operator=(const AccountSnapshot &) = delete;
+
+        // nullptr if the file is missing, truncated, not a snapshot || its sections don't fit the file;
+        // only the header is read, damaged records && index slots are rejected by the lookups that reach them
+        static std::unique_ptr<AccountSnapshot> load(const std::string & path);
+
+        // writes every account of atm to path (via a temp file + rename, so readers never see a partial file)
+        // accounts && their histories are copied one at a time, the ATM keeps serving meanwhile;
+        // with a journal, the file only replaces path once everything in it is durable in the journal
+        static bool write(const std::string & path, const ATM & atm);
+
+        // write, then drop the journal records the new snapshot covers: on restart, attachSnapshot
+        // followed by replayJournal rebuilds the same state from a short journal
+        static bool checkpoint(const std::string & path, const ATM & atm);
+
+        std::size_t size() const
+        {
+            return header->accountCount;
+        }
+
+        // every journal record up to this one is included, replay only needs the later ones
+        std::uint64_t coveredLsn() const
+        {
+            return header->journalLsn;
+        }
+
+        // nullptr if the record at position is damaged
+        const SnapshotAccount * at(std::size_t position) const
+        {
+            return isIntact(accounts[position]) ? &accounts[position] : nullptr;
+        }
+
+        // only reads the record's number: empty if its length is damaged
+        std::string_view accountNumberAt(std::size_t position) const
+        {
+            const SnapshotAccount & account = accounts[position];
+            return (account.numberLength <= SnapshotAccount::maxNumberLength) ? account.getAccountNumber() : std::string_view{};
+        }
+
+        // nullptr if absent, || if the record (|| an index slot on the way to it) is damaged
+        const SnapshotAccount * find(std::string_view accountNumber) const
+        {
+            const SnapshotAccount * account = probe(accountNumber);
+            return (account != nullptr && isIntact(*account)) ? account : nullptr;
+        }
+
+        // the number is taken by a record, damaged or not
+        bool contains(std::string_view accountNumber) const
+        {
+            return probe(accountNumber) != nullptr;
+        }
+
+        // columns of a record returned by find || at
+
+        std::span<const TransactionType> typeColumn(const SnapshotAccount & account) const
+        {
+            return {types + account.firstTransaction, account.transactionCount};
+        }
+
+        std::span<const std::int64_t> amountColumn(const SnapshotAccount & account) const
+        {
+            return {amounts + account.firstTransaction, account.transactionCount};
+        }
+
+        std::span<const std::int64_t> timeStampColumn(const SnapshotAccount & account) const
+        {
+            return {timeStamps + account.firstTransaction, account.transactionCount};
+        }
+};
+
+// background job: checkpoints (see AccountSnapshot::checkpoint) every interval until destroyed
+class SnapshotWriter
+{
+    private:
+        std::mutex waitMutex;
+        std::condition_variable_any wakeUp;
+        std::jthread worker; // last member: stopped && joined first
+
+    public:
+        SnapshotWriter(const ATM & atm, std::string path, std::chrono::seconds interval);
+};
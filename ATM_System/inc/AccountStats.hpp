@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array> // per-type totals
+#include <chrono> // calendar months
+#include <cstdint> // cents, days
+#include <cstddef> // size_t
+#include <limits> // min / max sentinels
+#include <algorithm> // min, max
+#include <initializer_list> // limited types
+#include "Money.hpp"
+
+// running aggregates kept next to a transaction log, every update && query is O(1)
+// sums saturate instead of wrapping; a saturated withdrawal total just keeps every limit exhausted
+// limited types (withdrawals && outgoing transfers) share one day && one month total, both periods
+// are UTC calendar ones: the day turns over at 00:00 UTC && the month on the 1st at 00:00 UTC,
+// whatever local time zone formatTime shows the history in
+template <std::size_t TypeCount>
+class AccountStats
+{
+    public:
+        struct Totals
+        {
+            std::int64_t sumCents = 0;
+            std::uint64_t count = 0;
+            std::int64_t minCents = std::numeric_limits<std::int64_t>::max();
+            std::int64_t maxCents = std::numeric_limits<std::int64_t>::min();
+        };
+
+        static constexpr std::int64_t secondsPerDay = 86'400;
+
+    private:
+        static constexpr std::int64_t noPeriod = std::numeric_limits<std::int64_t>::min(); // nothing withdrawn yet
+
+        std::array<Totals, TypeCount> totals{};
+
+        std::uint32_t limitedTypes = 0; // bit per type index
+
+        // limited amounts of the latest UTC day && calendar month that saw one; timestamps never go back,
+        // so an older period is over for good && is only ever compared for equality, never subtracted
+        std::int64_t withdrawalDay = noPeriod;
+        std::int64_t withdrawnDayCents = 0;
+        std::int64_t withdrawalMonth = noPeriod; // year * 12 + month - 1
+        std::int64_t withdrawnMonthCents = 0;
+
+        static void addSaturating(std::int64_t & sumCents, std::int64_t amountCents)
+        {
+            Money sum = Money::fromCents(sumCents);
+            sumCents = Money::tryAdd(sum, Money::fromCents(amountCents), sum) ? sum.getCents()
+                     : (amountCents > 0) ? std::numeric_limits<std::int64_t>::max() : std::numeric_limits<std::int64_t>::min();
+        }
+
+        static std::int64_t dayOf(std::int64_t timeStamp)
+        {
+            return (timeStamp >= 0) ? timeStamp / secondsPerDay : (timeStamp - secondsPerDay + 1) / secondsPerDay;
+        }
+
+        static std::int64_t monthOf(std::int64_t day)
+        {
+            const std::chrono::year_month_day date{std::chrono::sys_days{std::chrono::days{day}}};
+            return static_cast<std::int64_t>(static_cast<int>(date.year())) * 12 + static_cast<unsigned>(date.month()) - 1;
+        }
+
+    public:
+        // limitedTypeIndexes: the types counted against the day && month totals
+        explicit AccountStats(std::initializer_list<std::size_t> limitedTypeIndexes)
+        {
+            for (const std::size_t type : limitedTypeIndexes)
+            {
+                limitedTypes |= std::uint32_t{1} << type;
+            }
+        }
+
+        void record(std::size_t type, std::int64_t amountCents, std::int64_t timeStamp)
+        {
+            Totals & typeTotals = totals[type];
+            addSaturating(typeTotals.sumCents, amountCents);
+            ++typeTotals.count;
+            typeTotals.minCents = std::min(typeTotals.minCents, amountCents);
+            typeTotals.maxCents = std::max(typeTotals.maxCents, amountCents);
+
+            if ((limitedTypes >> type) & 1)
+            {
+                const std::int64_t day = dayOf(timeStamp);
+                if (withdrawalDay != day)
+                {
+                    withdrawalDay = day;
+                    withdrawnDayCents = 0;
+                    const std::int64_t month = monthOf(day);
+                    if (withdrawalMonth != month)
+                    {
+                        withdrawalMonth = month;
+                        withdrawnMonthCents = 0;
+                    }
+                }
+                addSaturating(withdrawnDayCents, amountCents);
+                addSaturating(withdrawnMonthCents, amountCents);
+            }
+        }
+
+        const Totals & getTotals(std::size_t type) const
+        {
+            return totals[type];
+        }
+
+        // UTC day of timeStamp
+        std::int64_t withdrawnOnDayOf(std::int64_t timeStamp) const
+        {
+            return (withdrawalDay == dayOf(timeStamp)) ? withdrawnDayCents : 0;
+        }
+
+        // calendar month (UTC) of timeStamp
+        std::int64_t withdrawnInMonthOf(std::int64_t timeStamp) const
+        {
+            const std::int64_t day = dayOf(timeStamp);
+            return (withdrawalDay == day || withdrawalMonth == monthOf(day)) ? withdrawnMonthCents : 0;
+        }
+};
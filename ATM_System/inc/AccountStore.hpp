@@ -0,0 +1,154 @@
+#pragma once
+
+#include <string> // file path, account numbers
+#include <string_view> // lightweight string lib
+#include <vector> // record locations, scratch buffers
+#include <memory> // loaded accounts
+#include <mutex> // file && index access
+#include <cstdint> // fixed width on-disk layout
+#include <cstddef> // size_t
+#include "Account.hpp"
+#include "AccountIndex.hpp"
+#include "TransactionCodec.hpp"
+
+// on-disk layout: [StoreHeader] padded to 64 bytes, then one slot per record, each slot a power of two
+// bytes (so every slot starts on a 64 byte boundary):
+// [StoreRecord][account number][history in TransactionCodec format][unused tail]
+// a save never overwrites the account's current record: it goes to another slot (a free one of the
+// same size, or a new one at the end, twice the record size) with a higher generation, && the old
+// slot is only reused after the next sync(), once the new record is known to be on disk
+// opening the store keeps the highest generation of each account number whose checksum matches
+struct StoreHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+};
+
+struct StoreRecord
+{
+    std::uint32_t capacity; // slot size, header included
+    std::uint32_t checksum; // FNV-1a of the record (with this field zeroed), the slot's unused tail excluded
+    std::uint64_t generation; // store-wide save counter
+    std::int32_t pin;
+    std::uint8_t numberLength;
+    std::uint8_t reserved[3];
+    std::int64_t balanceCents;
+    std::int64_t dailyLimitCents; // WithdrawalLimits
+    std::int64_t monthlyLimitCents;
+    std::uint64_t journalLsn; // last journal record the record includes, see AccountCache::recover
+    std::uint64_t historyBytes;
+};
+
+static_assert(sizeof(StoreHeader) % 8 == 0 && sizeof(StoreRecord) % 8 == 0, "store records must stay 8-byte aligned");
+
+// every account, resident or not, for AccountCache to load from && write back to
+// only the account numbers && slot locations are kept in memory
+// thread-safe; reads && writes go straight to the file (pread / pwrite), sync() makes them durable
+class AccountStore
+{
+    private:
+        struct Location
+        {
+            std::uint64_t offset;
+            std::uint32_t capacity;
+            std::uint64_t generation;
+        };
+
+        int fd = -1;
+        std::uint64_t fileEnd = 0;
+        std::uint64_t nextGeneration = 1;
+        std::uint64_t deadBytes = 0; // free, retired && unreadable slots
+        std::vector<std::string> numbers; // by position
+        std::vector<Location> locations;
+        std::vector<std::vector<std::uint64_t>> freeSlots; // offsets of reusable slots, by log2 of their size
+        std::vector<Location> retiredSlots; // replaced since the last sync(), not reusable yet
+        AccountIndex index;
+        mutable std::mutex storeMutex;
+        mutable std::vector<std::uint8_t> scratch; // record buffer, guarded by storeMutex
+        TransactionWriter history; // guarded by storeMutex
+
+        auto keyAt() const
+        {
+            return [this](std::size_t position) { return std::string_view(numbers[position]); };
+        }
+
+        // call with storeMutex held: encodes account into scratch, returns the record size
+        std::size_t encodeLocked(const Account & account);
+
+        // call with storeMutex held: writes scratch to a slot for position (new if it's npos), updates the index
+        bool writeLocked(std::size_t position, std::string_view accountNumber, std::size_t recordSize);
+
+        // call with storeMutex held: a free slot of capacity bytes, or a new one at the end of the file
+        std::uint64_t claimSlotLocked(std::uint32_t capacity);
+
+    public:
+        static constexpr std::uint32_t formatVersion = 4;
+        static constexpr std::size_t maxNumberLength = 255;
+
+        // opens (or creates) the store at path && indexes the current record of every account;
+        // torn or corrupt records are skipped (their space is not reused)
+        // throws std::system_error if the file can't be opened or isn't a store
+        explicit AccountStore(const std::string & path);
+        ~AccountStore();
+
+        AccountStore(const AccountStore &) = delete;
+        AccountStore & operator=(const AccountStore &) = delete;
+
+        // false if the account number is already stored, longer than maxNumberLength or the write fails
+        bool add(const Account & account);
+
+        // write-back of a known account (balance, PIN, withdrawal limits && the whole history); false if unknown or the write fails
+        bool save(const Account & account);
+
+        // nullptr if the account is unknown or its record can't be read (or fails its checksum)
+        std::unique_ptr<Account> load(std::string_view accountNumber) const;
+
+        bool contains(std::string_view accountNumber) const
+        {
+            std::lock_guard lock(storeMutex);
+            return index.find(accountNumber, keyAt()) != AccountIndex::npos;
+        }
+
+        std::size_t size() const
+        {
+            std::lock_guard lock(storeMutex);
+            return numbers.size();
+        }
+
+        // accounts are never removed, so a position names the same account for the store's lifetime
+        // npos if the account is unknown
+        std::size_t positionOf(std::string_view accountNumber) const
+        {
+            std::lock_guard lock(storeMutex);
+            return index.find(accountNumber, keyAt());
+        }
+
+        // empty if no account has that position
+        std::string numberAt(std::size_t position) const
+        {
+            std::lock_guard lock(storeMutex);
+            return (position < numbers.size()) ? numbers[position] : std::string();
+        }
+
+        // visit(accountNumber) for every stored account, in position order, with the store locked
+        template <typename Visitor>
+        void forEachNumber(Visitor visit) const
+        {
+            std::lock_guard lock(storeMutex);
+            for (const std::string & accountNumber : numbers)
+            {
+                visit(std::string_view(accountNumber));
+            }
+        }
+
+        // slots not holding a current record: free, waiting for sync(), or unreadable
+        std::uint64_t wastedBytes() const
+        {
+            std::lock_guard lock(storeMutex);
+            return deadBytes;
+        }
+
+        // fdatasync: everything saved so far survives a crash; the slots it replaced become reusable
+        bool sync();
+};
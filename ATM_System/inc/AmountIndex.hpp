@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array> // one permutation per transaction type
+#include <vector> // sorted positions, query results
+#include <cstdint> // cents, positions
+#include <cstddef> // size_t
+#include <algorithm> // stable_sort, inplace_merge, partition_point
+
+// secondary index over a transaction log, ordered by amount within each type
+// nothing happens on append: the first query sorts the positions, later ones sort only the rows
+// appended since && merge them in, so accounts that are never queried hold no index at all
+// the log is read through accessors: typeAt(position) (as an index) && amountAt(position) (cents)
+template <std::size_t TypeCount>
+class AmountIndex
+{
+    private:
+        // positions of each type, ascending by (amount, position): equal amounts keep chronological order
+        std::array<std::vector<std::uint64_t>, TypeCount> byType;
+        std::size_t indexedCount = 0; // log positions below this one are in byType
+
+        template <typename AmountAt>
+        static auto byAmountThenPosition(AmountAt & amountAt)
+        {
+            return [&amountAt](std::uint64_t left, std::uint64_t right)
+            {
+                const std::int64_t leftCents = amountAt(left);
+                const std::int64_t rightCents = amountAt(right);
+                return leftCents < rightCents || (leftCents == rightCents && left < right);
+            };
+        }
+
+    public:
+        // indexes log positions [indexed, count): O(k log k) for k new rows + a linear merge per type
+        template <typename TypeAt, typename AmountAt>
+        void catchUp(std::size_t count, TypeAt typeAt, AmountAt amountAt)
+        {
+            if (count <= indexedCount)
+            {
+                return;
+            }
+
+            std::array<std::ptrdiff_t, TypeCount> middles;
+            for (std::size_t type = 0; type < TypeCount; ++type)
+            {
+                middles[type] = static_cast<std::ptrdiff_t>(byType[type].size());
+            }
+            for (std::size_t position = indexedCount; position < count; ++position)
+            {
+                byType[typeAt(position)].push_back(position);
+            }
+
+            for (std::size_t type = 0; type < TypeCount; ++type)
+            {
+                std::vector<std::uint64_t> & positions = byType[type];
+                // new positions are ascending already, a stable sort by amount orders ties chronologically
+                std::stable_sort(positions.begin() + middles[type], positions.end(), [&amountAt](std::uint64_t left, std::uint64_t right)
+                {
+                    return amountAt(left) < amountAt(right);
+                });
+                std::inplace_merge(positions.begin(), positions.begin() + middles[type], positions.end(), byAmountThenPosition(amountAt));
+            }
+            indexedCount = count;
+        }
+
+        // drops the index && its memory, the next query rebuilds it
+        void clear()
+        {
+            for (auto & positions : byType)
+            {
+                std::vector<std::uint64_t>().swap(positions);
+            }
+            indexedCount = 0;
+        }
+
+        // forgets every position from keep on (the log was truncated)
+        void truncate(std::size_t keep)
+        {
+            if (keep >= indexedCount)
+            {
+                return;
+            }
+            for (auto & positions : byType)
+            {
+                std::erase_if(positions, [keep](std::uint64_t position) { return position >= keep; });
+            }
+            indexedCount = keep;
+        }
+
+        // queries cover the positions indexed by the last catchUp
+
+        // positions of the k largest amounts of type, largest first
+        std::vector<std::uint64_t> largest(std::size_t type, std::size_t k) const
+        {
+            const std::vector<std::uint64_t> & positions = byType[type];
+            return std::vector<std::uint64_t>(positions.rbegin(), positions.rbegin() + static_cast<std::ptrdiff_t>(std::min(k, positions.size())));
+        }
+
+        // positions with low <= amount <= high, ascending by amount
+        template <typename AmountAt>
+        std::vector<std::uint64_t> inRange(std::size_t type, std::int64_t lowCents, std::int64_t highCents, AmountAt amountAt) const
+        {
+            const std::vector<std::uint64_t> & positions = byType[type];
+            const auto first = std::partition_point(positions.begin(), positions.end(), [&](std::uint64_t position) { return amountAt(position) < lowCents; });
+            const auto last = std::partition_point(first, positions.end(), [&](std::uint64_t position) { return amountAt(position) <= highCents; });
+            return std::vector<std::uint64_t>(first, last);
+        }
+
+        // every position of every type, ascending by amount (ties chronological)
+        template <typename AmountAt>
+        std::vector<std::uint64_t> ascending(AmountAt amountAt) const
+        {
+            std::vector<std::uint64_t> merged;
+            for (const auto & positions : byType)
+            {
+                const auto middle = static_cast<std::ptrdiff_t>(merged.size());
+                merged.insert(merged.end(), positions.begin(), positions.end());
+                std::inplace_merge(merged.begin(), merged.begin() + middle, merged.end(), byAmountThenPosition(amountAt));
+            }
+            return merged;
+        }
+};
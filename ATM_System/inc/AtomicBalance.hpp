@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic> // lock-free balance
+#include <cstdint> // int64 cents
+
+// balance kept as a 64-bit count of cents, updated without taking any lock
+class AtomicBalance
+{
+    private:
+        std::atomic<std::int64_t> cents;
+
+    public:
+        explicit AtomicBalance(std::int64_t initialCents) : cents(initialCents) {}
+
+        std::int64_t load() const
+        {
+            return cents.load(std::memory_order_acquire);
+        }
+
+        // CAS loop as well, so a credit can never wrap the balance around
+        // returns false (balance untouched) on overflow
+        bool tryCredit(std::int64_t amountCents, std::int64_t & newBalanceCents)
+        {
+            std::int64_t current = cents.load(std::memory_order_relaxed);
+            std::int64_t next;
+            do
+            {
+                if (__builtin_add_overflow(current, amountCents, &next))
+                {
+                    newBalanceCents = current;
+                    return false;
+                }
+            } while (!cents.compare_exchange_weak(current, next,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed));
+
+            newBalanceCents = next;
+            return true;
+        }
+
+        // unconditional update, only for replaying already-validated history
+        void restore(std::int64_t deltaCents)
+        {
+            cents.fetch_add(deltaCents, std::memory_order_acq_rel);
+        }
+
+        // CAS loop: the overdraft check && the subtraction are one atomic step
+        // returns false (balance untouched) if amountCents exceeds the balance
+        bool tryDebit(std::int64_t amountCents, std::int64_t & newBalanceCents)
+        {
+            std::int64_t current = cents.load(std::memory_order_relaxed);
+            do
+            {
+                if (amountCents > current)
+                {
+                    newBalanceCents = current;
+                    return false;
+                }
+            } while (!cents.compare_exchange_weak(current, current - amountCents,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed));
+
+            newBalanceCents = current - amountCents;
+            return true;
+        }
+};
+
+static_assert(std::atomic<std::int64_t>::is_always_lock_free, "balance updates must not fall back to a lock");
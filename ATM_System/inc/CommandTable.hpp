@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array> // command specs && slot table
+#include <cstdint> // hash seeds
+#include <cstddef> // size_t
+#include <charconv> // from_chars
+#include <string_view> // lightweight string lib
+#include "Money.hpp"
+
+// what a command expects after its name
+enum class ArgumentKind : std::uint8_t
+{
+    None,
+    Amount, // "<money>"
+    Credentials // "<account> <pin>"
+};
+
+// arguments, already parsed && validated before the handler runs
+struct ParsedArguments
+{
+    Money amount;
+    std::string_view accountNumber;
+    int pin = 0;
+};
+
+enum class DispatchResult : std::uint8_t
+{
+    Handled,
+    UnknownCommand,
+    BadArguments
+};
+
+template <typename Context>
+struct CommandSpec
+{
+    using Handler = void (*)(Context &, const ParsedArguments &);
+
+    std::string_view name;
+    ArgumentKind arguments;
+    Handler handler;
+};
+
+// compile-time command table: the constructor searches (at compile time, when the table is constexpr)
+// for a hash seed that maps every command name to its own slot, so a lookup is one hash,
+// one slot && one string compare; unknown names are rejected after that single probe
+template <typename Context, std::size_t N>
+class CommandTable
+{
+    private:
+        static constexpr std::size_t slotCount = [] {
+            std::size_t size = 1;
+            while (size < N * 2)
+            {
+                size *= 2;
+            }
+            return size;
+        }();
+
+        static constexpr std::uint8_t emptySlot = 0xFF;
+
+        std::array<CommandSpec<Context>, N> specs;
+        std::array<std::uint8_t, slotCount> slots{};
+        std::uint32_t seed = 0;
+
+        static constexpr std::uint32_t hash(std::string_view name, std::uint32_t hashSeed)
+        {
+            std::uint32_t value = 2166136261U ^ hashSeed;
+            for (const char c : name)
+            {
+                value ^= static_cast<unsigned char>(c);
+                value *= 16777619U;
+            }
+            return value ^ (value >> 15);
+        }
+
+        static constexpr std::string_view nextToken(std::string_view & line)
+        {
+            std::size_t start = 0;
+            while (start < line.size() && line[start] == ' ')
+            {
+                ++start;
+            }
+            std::size_t end = start;
+            while (end < line.size() && line[end] != ' ')
+            {
+                ++end;
+            }
+            const std::string_view token = line.substr(start, end - start);
+            line.remove_prefix(end);
+            return token;
+        }
+
+        static bool parseArguments(ArgumentKind kind, std::string_view line, ParsedArguments & arguments)
+        {
+            switch (kind)
+            {
+                case ArgumentKind::None:
+                    break;
+
+                case ArgumentKind::Amount:
+                {
+                    const auto amount = Money::parse(nextToken(line));
+                    if (!amount)
+                    {
+                        return false;
+                    }
+                    arguments.amount = *amount;
+                    break;
+                }
+
+                case ArgumentKind::Credentials:
+                {
+                    arguments.accountNumber = nextToken(line);
+                    const std::string_view pinText = nextToken(line);
+                    const auto [end, error] = std::from_chars(pinText.data(), pinText.data() + pinText.size(), arguments.pin);
+                    if (arguments.accountNumber.empty() || error != std::errc{} || end != pinText.data() + pinText.size())
+                    {
+                        return false;
+                    }
+                    break;
+                }
+            }
+
+            return nextToken(line).empty(); // no trailing garbage
+        }
+
+    public:
+        constexpr explicit CommandTable(const std::array<CommandSpec<Context>, N> & commandSpecs) : specs(commandSpecs)
+        {
+            static_assert(N < emptySlot, "too many commands for 8-bit slots");
+
+            for (std::uint32_t candidate = 0; ; ++candidate)
+            {
+                slots.fill(emptySlot);
+                bool isPerfect = true;
+                for (std::size_t i = 0; i < N && isPerfect; ++i)
+                {
+                    std::uint8_t & slot = slots[hash(specs[i].name, candidate) & (slotCount - 1)];
+                    isPerfect = (slot == emptySlot);
+                    slot = static_cast<std::uint8_t>(i);
+                }
+                if (isPerfect)
+                {
+                    seed = candidate;
+                    return;
+                }
+            }
+        }
+
+        // "<name> [arguments]" -> parse arguments for that command && call its handler
+        DispatchResult dispatch(Context & context, std::string_view line) const
+        {
+            const std::string_view name = nextToken(line);
+            const std::uint8_t slot = slots[hash(name, seed) & (slotCount - 1)];
+            if (slot == emptySlot || specs[slot].name != name)
+            {
+                return DispatchResult::UnknownCommand;
+            }
+
+            ParsedArguments arguments;
+            if (!parseArguments(specs[slot].arguments, line, arguments))
+            {
+                return DispatchResult::BadArguments;
+            }
+
+            specs[slot].handler(context, arguments);
+            return DispatchResult::Handled;
+        }
+};
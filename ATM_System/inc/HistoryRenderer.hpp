@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vector> // preallocated output buffer
+#include <string_view> // lightweight string lib
+#include <cstring> // memcpy
+#include <charconv> // to_chars
+#include <cerrno> // EINTR
+#include <unistd.h> // write
+#include "Transactions.hpp"
+
+// which slice of a history to render: offset/limit, or everything after a timestamp
+struct PageRequest
+{
+    std::size_t offset = 0;
+    std::size_t limit = 1024;
+    bool isAfterTimeStamp = false;
+    std::int64_t afterTimeStamp = 0; // used instead of offset when isAfterTimeStamp
+};
+
+// what was rendered && where the next page starts
+struct HistoryPage
+{
+    std::size_t first = 0;
+    std::size_t count = 0;
+    std::size_t total = 0;
+    std::size_t nextOffset = 0; // cursor for the following request
+
+    bool hasMore() const
+    {
+        return nextOffset < total;
+    }
+};
+
+// formats history lines into one reusable buffer && emits each page with a single write()
+class HistoryRenderer
+{
+    private:
+        // "Transfer Out of -92233720368547758.08 $ on YYYY-MM-DD HH:MM:SS\n"
+        static constexpr std::size_t maxLineLength = 16 + Money::maxFormattedLength + 6 + formattedTimeLength + 1;
+
+        std::vector<char> buffer;
+        std::size_t used = 0;
+
+        char * reserveBytes(std::size_t count)
+        {
+            if (used + count > buffer.size())
+            {
+                buffer.resize(std::max(buffer.size() * 2, used + count));
+            }
+            return buffer.data() + used;
+        }
+
+    public:
+        explicit HistoryRenderer(std::size_t capacityBytes = 1 << 16) : buffer(capacityBytes) {}
+
+        void clear()
+        {
+            used = 0;
+        }
+
+        std::string_view view() const
+        {
+            return std::string_view(buffer.data(), used);
+        }
+
+        void appendText(std::string_view text)
+        {
+            std::memcpy(reserveBytes(text.size()), text.data(), text.size());
+            used += text.size();
+        }
+
+        void appendNumber(std::size_t value)
+        {
+            char * out = reserveBytes(20);
+            used = static_cast<std::size_t>(std::to_chars(out, out + 20, value).ptr - buffer.data());
+        }
+
+        void appendLine(const Transaction & transaction)
+        {
+            char * const start = reserveBytes(maxLineLength);
+            char * out = start;
+
+            const std::string_view type = toString(transaction.type);
+            std::memcpy(out, type.data(), type.size());
+            out += type.size();
+            std::memcpy(out, " of ", 4);
+            out = transaction.amount.format(out + 4, out + 4 + Money::maxFormattedLength);
+            std::memcpy(out, " $ on ", 6);
+            out = formatTime(transaction.timeStamp, out + 6);
+            *out++ = '\n';
+
+            used += static_cast<std::size_t>(out - start);
+        }
+
+        // formats the requested slice of history, returns where it started && where the next page starts
+        HistoryPage appendPage(const HistorySnapshot & history, const PageRequest & request)
+        {
+            HistoryPage page;
+            page.total = history.size();
+            page.first = std::min(request.isAfterTimeStamp ? history.firstAfter(request.afterTimeStamp) : request.offset, page.total);
+            page.count = std::min(request.limit, page.total - page.first);
+            page.nextOffset = page.first + page.count;
+
+            for (std::size_t i = page.first; i < page.nextOffset; ++i)
+            {
+                appendLine(history[i]);
+            }
+            return page;
+        }
+
+        // one system call per page (loops only on a partial write), false on error
+        bool flush(int fd)
+        {
+            const char * data = buffer.data();
+            std::size_t remaining = used;
+            while (remaining > 0)
+            {
+                const ssize_t written = ::write(fd, data, remaining);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written;
+                remaining -= static_cast<std::size_t>(written);
+            }
+            used = 0;
+            return true;
+        }
+};
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <atomic> // single-writer counters, readable from another process
+#include <array> // merged buckets
+#include <string> // segment name
+#include <utility> // move
+#include <string_view> // operation names
+#include <memory> // unique_ptr factory
+#include <cstdint> // fixed width shared layout
+#include <cstddef> // size_t
+#include <bit> // bit_width
+#include <chrono> // tick source off x86
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // __rdtsc
+#endif
+
+// every instrumented ATM / Account entry point
+enum class MetricOp : std::uint8_t
+{
+    AddAccount,
+    Authenticate,
+    Deposite,
+    Withdraw,
+    ApplyBatch,
+    RenderHistory,
+    SortByAmount,
+    Transfer,
+    Settle,
+    LoadAccount, // AccountCache miss: read from the AccountStore, including any eviction it needs
+    EvictAccount // AccountCache victim written back && dropped
+};
+
+constexpr std::size_t metricOpCount = 11;
+
+constexpr std::string_view toString(MetricOp op)
+{
+    constexpr std::string_view names[metricOpCount] = {
+        "addAccount", "authenticate", "deposite", "withdraw", "applyBatch", "renderHistory", "sortByAmount", "transfer", "settle",
+        "loadAccount", "evictAccount"
+    };
+    return names[static_cast<std::size_t>(op)];
+}
+
+// cycle counter where there is one (a few ns), steady_clock nanoseconds elsewhere
+inline std::uint64_t readTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// shared-memory layout: [MetricsHeader][MetricsSlot x slotCount]
+// a slot belongs to one thread at a time, so its counters are bumped with plain load + store
+// (no locked instructions); readers merge all slots whenever they like
+constexpr std::size_t metricBucketCount = 64; // bucket b counts durations of bit_width(ticks) == b
+
+struct OperationCounters
+{
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> failures{0};
+    std::atomic<std::uint64_t> ticks{0}; // sum, for the mean
+    std::atomic<std::uint64_t> buckets[metricBucketCount]{};
+};
+
+struct alignas(64) MetricsSlot
+{
+    std::atomic<std::uint32_t> owner{0}; // 0 = free
+    std::uint32_t isShared = 0; // overflow slot, written with atomic adds by every thread beyond slotCount - 1
+    OperationCounters operations[metricOpCount];
+};
+
+struct MetricsHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t slotCount;
+    std::uint32_t opCount;
+    std::uint32_t bucketCount;
+    double ticksPerNanosecond;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "metrics counters are shared between processes");
+
+// merged view of one operation across every slot
+struct OperationSummary
+{
+    std::uint64_t count = 0;
+    std::uint64_t failures = 0;
+    double meanNanoseconds = 0;
+    std::array<std::uint64_t, metricBucketCount> buckets{};
+
+    // upper bound of the bucket holding the quantile, in ns
+    double percentileNanoseconds(double quantile, double ticksPerNanosecond) const;
+};
+
+// process-wide metrics: recording is always on && costs two tick reads + three relaxed stores
+// the segment is anonymous memory until publish() is called, then it is a named POSIX shm object
+class Metrics
+{
+    private:
+        static inline thread_local MetricsSlot * slot = nullptr;
+
+        // first record() on a thread: takes a free slot (or the shared overflow slot)
+        static MetricsSlot * claimSlot();
+
+        static void bump(std::atomic<std::uint64_t> & counter, std::uint64_t delta, bool isShared)
+        {
+            if (isShared)
+            {
+                counter.fetch_add(delta, std::memory_order_relaxed);
+            }
+            else
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+            }
+        }
+
+    public:
+        static constexpr std::uint32_t formatVersion = 2; // 2: 11 operations
+        static constexpr std::uint32_t maxThreads = 256;
+
+        static void record(MetricOp op, std::uint64_t ticks, bool isSuccess)
+        {
+            MetricsSlot * target = (slot != nullptr) ? slot : claimSlot();
+            OperationCounters & counters = target->operations[static_cast<std::size_t>(op)];
+            const bool isShared = (target->isShared != 0);
+            const auto bucket = static_cast<std::size_t>(std::bit_width(ticks));
+            bump(counters.count, 1, isShared);
+            bump(counters.ticks, ticks, isShared);
+            bump(counters.buckets[bucket < metricBucketCount ? bucket : metricBucketCount - 1], 1, isShared);
+            if (!isSuccess)
+            {
+                bump(counters.failures, 1, isShared);
+            }
+        }
+
+        // exports the segment as /dev/shm/<name> for a scraper; must run before the first record()
+        // throws std::system_error if the counters are already in use in this process, a segment
+        // with that name already exists (it is left alone) or shm_open fails
+        static void publish(const std::string & name);
+
+        // the name a process publishes its metrics under: one segment per process
+        static std::string segmentName(long pid);
+
+        // removes the name again, the mapping stays valid for this process
+        static void unpublish(const std::string & name);
+
+        // merge of this process' own slots
+        static OperationSummary summarize(MetricOp op);
+
+        static double ticksPerNanosecond();
+};
+
+// publishes the process' metrics for the lifetime of the object
+class MetricsExport
+{
+    private:
+        std::string name;
+
+    public:
+        explicit MetricsExport(std::string segmentName) : name(std::move(segmentName))
+        {
+            Metrics::publish(name);
+        }
+
+        ~MetricsExport()
+        {
+            Metrics::unpublish(name);
+        }
+
+        MetricsExport(const MetricsExport &) = delete;
+        MetricsExport & operator=(const MetricsExport &) = delete;
+};
+
+// times one operation: records on destruction, failed() marks the outcome
+class MetricTimer
+{
+    private:
+        MetricOp op;
+        std::uint64_t start;
+        bool isSuccess = true;
+
+    public:
+        explicit MetricTimer(MetricOp op) : op(op), start(readTicks()) {}
+
+        ~MetricTimer()
+        {
+            Metrics::record(op, readTicks() - start, isSuccess);
+        }
+
+        MetricTimer(const MetricTimer &) = delete;
+        MetricTimer & operator=(const MetricTimer &) = delete;
+
+        void failed()
+        {
+            isSuccess = false;
+        }
+};
+
+// read-only mapping of another process' published segment
+class MetricsReader
+{
+    private:
+        void * mapping = nullptr;
+        std::size_t mappingSize = 0;
+        const MetricsHeader * header = nullptr;
+        const MetricsSlot * slots = nullptr;
+
+        MetricsReader() = default;
+
+    public:
+        ~MetricsReader();
+        MetricsReader(const MetricsReader &) = delete;
+        MetricsReader & operator=(const MetricsReader &) = delete;
+
+        // nullptr if nothing is published under name or the layout doesn't match
+        static std::unique_ptr<MetricsReader> open(const std::string & name);
+
+        OperationSummary summarize(MetricOp op) const;
+
+        double ticksPerNanosecond() const
+        {
+            return header->ticksPerNanosecond;
+        }
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <iostream> // in/out stream
+#include <cstdint> // int64 minor units
+#include <compare> // three-way comparison
+#include <charconv> // to_chars / from_chars (no locale, no allocation)
+#include <optional> // parse result
+#include <stdexcept> // overflow_error
+#include <string_view> // lightweight string lib
+
+// fixed-point amount: a signed 64-bit count of minor units (cents)
+class Money
+{
+    private:
+        std::int64_t cents = 0;
+
+        constexpr explicit Money(std::int64_t minorUnits) : cents(minorUnits) {}
+
+    public:
+        static constexpr std::int64_t centsPerUnit = 100;
+        static constexpr std::size_t maxFormattedLength = 24; // "-92233720368547758.08"
+
+        constexpr Money() = default;
+
+        static constexpr Money fromCents(std::int64_t minorUnits)
+        {
+            return Money(minorUnits);
+        }
+
+        static Money fromUnits(std::int64_t units)
+        {
+            std::int64_t minorUnits;
+            if (__builtin_mul_overflow(units, centsPerUnit, &minorUnits))
+            {
+                throw std::overflow_error("Money: amount out of range");
+            }
+            return Money(minorUnits);
+        }
+
+        // accepts "12", "12.3", "12.34", "-0.50"; anything else (or more than 2 decimals) is rejected
+        static std::optional<Money> parse(std::string_view text)
+        {
+            const bool isNegative = !text.empty() && text.front() == '-';
+            if (isNegative)
+            {
+                text.remove_prefix(1);
+            }
+
+            const std::size_t dot = text.find('.');
+            const std::string_view unitsText = text.substr(0, dot);
+            const std::string_view centsText = (dot == std::string_view::npos) ? std::string_view{} : text.substr(dot + 1);
+            if (unitsText.empty() || unitsText.front() < '0' || unitsText.front() > '9' || centsText.size() > 2 || (dot != std::string_view::npos && centsText.empty()))
+            {
+                return std::nullopt;
+            }
+
+            std::int64_t units = 0;
+            auto [unitsEnd, unitsError] = std::from_chars(unitsText.data(), unitsText.data() + unitsText.size(), units);
+            if (unitsError != std::errc{} || unitsEnd != unitsText.data() + unitsText.size())
+            {
+                return std::nullopt;
+            }
+
+            std::int64_t fraction = 0;
+            for (const char c : centsText)
+            {
+                if (c < '0' || c > '9')
+                {
+                    return std::nullopt;
+                }
+                fraction = fraction * 10 + (c - '0');
+            }
+            if (centsText.size() == 1)
+            {
+                fraction *= 10;
+            }
+
+            std::int64_t minorUnits;
+            if (__builtin_mul_overflow(units, centsPerUnit, &minorUnits) ||
+                __builtin_add_overflow(minorUnits, fraction, &minorUnits))
+            {
+                return std::nullopt;
+            }
+            return Money(isNegative ? -minorUnits : minorUnits);
+        }
+
+        constexpr std::int64_t getCents() const
+        {
+            return cents;
+        }
+
+        // overflow-checked arithmetic: false (&& result untouched) on overflow
+        static bool tryAdd(Money a, Money b, Money & result)
+        {
+            std::int64_t sum;
+            if (__builtin_add_overflow(a.cents, b.cents, &sum))
+            {
+                return false;
+            }
+            result.cents = sum;
+            return true;
+        }
+
+        static bool trySubtract(Money a, Money b, Money & result)
+        {
+            std::int64_t difference;
+            if (__builtin_sub_overflow(a.cents, b.cents, &difference))
+            {
+                return false;
+            }
+            result.cents = difference;
+            return true;
+        }
+
+        Money & operator+=(Money other)
+        {
+            if (!tryAdd(*this, other, *this))
+            {
+                throw std::overflow_error("Money: addition overflow");
+            }
+            return *this;
+        }
+
+        Money & operator-=(Money other)
+        {
+            if (!trySubtract(*this, other, *this))
+            {
+                throw std::overflow_error("Money: subtraction overflow");
+            }
+            return *this;
+        }
+
+        friend Money operator+(Money a, Money b)
+        {
+            return a += b;
+        }
+
+        friend Money operator-(Money a, Money b)
+        {
+            return a -= b;
+        }
+
+        friend constexpr auto operator<=>(Money, Money) = default;
+
+        // writes "units.cc" into [first, last), returns one past the last written char
+        // needs at most maxFormattedLength chars
+        char * format(char * first, char * last) const
+        {
+            // work on the magnitude as unsigned so INT64_MIN formats correctly
+            const bool isNegative = cents < 0;
+            const std::uint64_t magnitude = isNegative ? (0 - static_cast<std::uint64_t>(cents)) : static_cast<std::uint64_t>(cents);
+            const std::uint64_t units = magnitude / centsPerUnit;
+            const auto fraction = static_cast<unsigned>(magnitude % centsPerUnit);
+
+            if (isNegative && first != last)
+            {
+                *first++ = '-';
+            }
+            first = std::to_chars(first, last, units).ptr;
+            if (last - first >= 3)
+            {
+                first[0] = '.';
+                first[1] = static_cast<char>('0' + fraction / 10);
+                first[2] = static_cast<char>('0' + fraction % 10);
+                first += 3;
+            }
+            return first;
+        }
+
+        friend std::ostream & operator<<(std::ostream & os, Money money)
+        {
+            char buffer[maxFormattedLength];
+            return os.write(buffer, money.format(buffer, buffer + sizeof(buffer)) - buffer);
+        }
+};
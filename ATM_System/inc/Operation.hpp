@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint> // result codes
+#include <string_view> // lightweight string lib
+#include "Money.hpp"
+#include "Transactions.hpp"
+
+// one entry of a settlement batch
+struct Operation
+{
+    TransactionType type;
+    Money amount;
+};
+
+class Account;
+
+// one account's net movement within a transfer settlement
+struct NetPosition
+{
+    Account * account;
+    std::int64_t deltaCents; // > 0 credit, < 0 debit
+};
+
+// per-account caps on money leaving the account (withdrawals && outgoing transfers),
+// enforced in O(1) from the running day && month totals
+struct WithdrawalLimits
+{
+    static constexpr Money unlimited = Money::fromCents(INT64_MAX);
+
+    Money daily = unlimited; // calendar day (UTC)
+    Money monthly = unlimited; // calendar month (UTC)
+};
+
+enum class OperationResult : std::uint8_t
+{
+    Applied,
+    InvalidAmount,
+    InsufficientBalance,
+    BalanceOverflow,
+    JournalFailure,
+    LimitExceeded,
+    InvalidAccount, // stale handle, or a transfer to the same account
+    UnsupportedType, // transfer legs can't be applied one-sided
+    SettlementTooLarge // more accounts than one journal record holds
+};
+
+inline std::string_view toString(OperationResult result)
+{
+    switch (result)
+    {
+        case OperationResult::Applied:             return "Applied";
+        case OperationResult::InvalidAmount:       return "Invalid Amount";
+        case OperationResult::InsufficientBalance: return "Insufficient Balance";
+        case OperationResult::BalanceOverflow:     return "Balance Overflow";
+        case OperationResult::JournalFailure:      return "Journal Failure";
+        case OperationResult::LimitExceeded:       return "Limit Exceeded";
+        case OperationResult::InvalidAccount:      return "Invalid Account";
+        case OperationResult::UnsupportedType:     return "Unsupported Type";
+        case OperationResult::SettlementTooLarge:  return "Settlement Too Large";
+    }
+    return "Unknown";
+}
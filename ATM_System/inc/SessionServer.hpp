@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string> // socket path, line buffers
+#include <string_view> // lightweight string lib
+#include <coroutine> // C++20 coroutines
+#include <unordered_map> // suspended sessions by fd
+#include <map> // sessions waiting for the journal, by lsn
+#include <atomic> // stop flag
+#include <cstdint> // epoll event masks
+#include "ATM.hpp"
+
+// line protocol, one request per line, one response line each:
+//   LOGIN <account> <pin>   -> OK | ERR <reason>
+//   DEPOSIT <amount>        -> OK <balance> | ERR <reason>
+//   WITHDRAW <amount>       -> OK <balance> | ERR <reason>
+//   BALANCE                 -> OK <balance>
+//   QUIT                    -> BYE (connection closed)
+// a line longer than maxLineLength gets "ERR line too long" && the connection is closed
+//
+// single-threaded epoll loop; every connection is a coroutine that suspends
+// whenever its socket would block, so thousands of terminals share one thread
+// a DEPOSIT / WITHDRAW suspends its session until the journal has it on disk (the flusher's eventfd
+// wakes the loop), so one slow fdatasync never holds up the other sessions && they share group commits
+// attach the ATM's journal before constructing the server
+class SessionServer
+{
+    public:
+        // fire-and-forget coroutine: starts eagerly, frees its own frame when it finishes
+        struct DetachedTask
+        {
+            struct promise_type
+            {
+                DetachedTask get_return_object() { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() {}
+                void unhandled_exception() { std::terminate(); }
+            };
+        };
+
+    private:
+        // co_await readable(fd) / writable(fd): park the coroutine until epoll reports the fd ready
+        struct ReadyAwaiter
+        {
+            SessionServer & server;
+            int fd;
+            std::uint32_t events;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { server.watch(fd, events, handle); }
+            void await_resume() const noexcept {}
+        };
+
+        // co_await durable(lsn): park the coroutine until the journal has lsn on disk (true) or has failed (false)
+        struct DurableAwaiter
+        {
+            SessionServer & server;
+            std::uint64_t lsn;
+
+            bool await_ready() const { return lsn == 0 || server.journal->durability(lsn) != WalDurability::Pending; }
+            void await_suspend(std::coroutine_handle<> handle) { server.awaitingDurable.emplace(lsn, handle); }
+            bool await_resume() const { return lsn == 0 || server.journal->durability(lsn) == WalDurability::Durable; }
+        };
+
+        // a DEPOSIT / WITHDRAW parsed by handleLine, applied by the session itself so it can await the journal
+        struct DeferredOperation
+        {
+            AccountLease account; // empty: nothing deferred
+            Operation operation;
+        };
+
+        ATM & atm;
+        WriteAheadLog * journal; // nullptr: operations are final as soon as they are applied
+        std::string socketPath;
+        int listenFd = -1;
+        int epollFd = -1;
+        int wakeFd = -1; // eventfd, makes stop() interrupt epoll_wait
+        bool isBound = false; // the socket path is ours to unlink
+        std::atomic<bool> stopping{false};
+        std::unordered_map<int, std::coroutine_handle<>> suspended;
+        std::multimap<std::uint64_t, std::coroutine_handle<>> awaitingDurable;
+
+        // closes whatever fds are open && unlinks the socket path if it was bound
+        void release();
+
+        void watch(int fd, std::uint32_t events, std::coroutine_handle<> handle);
+        ReadyAwaiter readable(int fd);
+        ReadyAwaiter writable(int fd);
+        DurableAwaiter durable(std::uint64_t lsn);
+
+        // resumes every session whose lsn is now durable (or failed)
+        void resumeDurable();
+
+        DetachedTask acceptLoop();
+        DetachedTask session(int fd);
+
+        // executes one request line, appends the response line to out; account changes are
+        // handed back in deferred instead, the session applies them && answers
+        void handleLine(std::string_view line, AccountHandle & current, std::string & out, DeferredOperation & deferred);
+
+    public:
+        static constexpr std::size_t maxLineLength = 1024; // bytes, without the newline
+
+        // binds && listens on a Unix domain socket, throws std::system_error on failure
+        SessionServer(ATM & atm, std::string socketPath);
+        ~SessionServer();
+
+        SessionServer(const SessionServer &) = delete;
+        SessionServer & operator=(const SessionServer &) = delete;
+
+        // serves until stop() is called
+        void run();
+
+        // safe to call from any thread
+        void stop();
+};
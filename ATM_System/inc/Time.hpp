@@ -1,3 +1,15 @@
 #pragma once
 
-std::string getCurrentTime();
\ No newline at end of file
+#include <cstddef> // size_t
+#include <cstdint> // epoch seconds
+
+// "YYYY-MM-DD HH:MM:SS"
+constexpr std::size_t formattedTimeLength = 19;
+
+// raw timestamp for the hot path, formatting happens at display time
+std::int64_t getEpochSeconds();
+
+// writes exactly formattedTimeLength chars (no terminator) into out, returns out + formattedTimeLength
+// local time; years before 0000 || after 9999 clamp to 0000-01-01 00:00:00 / 9999-12-31 23:59:59
+// never allocates; repeated calls within the same second are a copy from a per-thread cache
+char * formatTime(std::int64_t epochSeconds, char * out);
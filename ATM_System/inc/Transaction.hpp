@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint> // fixed width fields
+#include <cstddef> // size_t
+#include <string_view> // type names
+#include "Money.hpp"
+
+enum class TransactionType : std::uint8_t
+{
+    Deposit,
+    Withdrawal,
+    TransferIn, // account-to-account legs, only the outgoing one counts against withdrawal limits
+    TransferOut
+};
+
+constexpr std::size_t transactionTypeCount = 4;
+
+inline std::string_view toString(TransactionType type)
+{
+    switch (type)
+    {
+        case TransactionType::Deposit:     return "Deposite";
+        case TransactionType::Withdrawal:  return "Withdrawal";
+        case TransactionType::TransferIn:  return "Transfer In";
+        case TransactionType::TransferOut: return "Transfer Out";
+    }
+    return "Unknown";
+}
+
+// money coming into the account
+constexpr bool isCredit(TransactionType type)
+{
+    return type == TransactionType::Deposit || type == TransactionType::TransferIn;
+}
+
+// one row of the log, assembled on demand from the columns
+class Transaction
+{
+    public:
+        TransactionType type;
+        Money amount;
+        std::int64_t timeStamp; // seconds since epoch
+};
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <vector> // growable output buffer
+#include <span> // zero-copy input
+#include <cstdint> // fixed width fields
+#include <cstddef> // size_t
+#include <cstring> // memcpy
+#include <optional> // rejected headers
+#include <algorithm> // max
+#include "Money.hpp"
+#include "Transaction.hpp"
+
+// compact binary transaction stream, version 1:
+//   header: "ATXC" [version u8]
+//   record: [type code u8][amount: zigzag LEB128 varint, cents][timeStamp: zigzag LEB128 varint, delta to the previous record]
+// the first record's delta is taken from 0; a typical record is 5-7 bytes instead of 24
+namespace transaction_codec
+{
+    constexpr std::uint8_t magic[4] = {'A', 'T', 'X', 'C'};
+    constexpr std::uint8_t version = 1;
+    constexpr std::size_t headerSize = sizeof(magic) + 1;
+    constexpr std::size_t maxVarintLength = 10;
+    constexpr std::size_t maxRecordLength = 1 + 2 * maxVarintLength;
+
+    inline std::uint64_t zigzag(std::int64_t value)
+    {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    inline std::int64_t unzigzag(std::uint64_t value)
+    {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    // out must have room for maxVarintLength bytes
+    inline std::uint8_t * putVarint(std::uint8_t * out, std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            *out++ = static_cast<std::uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<std::uint8_t>(value);
+        return out;
+    }
+
+    // nullptr on a truncated or overlong varint
+    inline const std::uint8_t * getVarint(const std::uint8_t * in, const std::uint8_t * end, std::uint64_t & value)
+    {
+        value = 0;
+        for (unsigned shift = 0; shift < 64 && in != end; shift += 7)
+        {
+            const std::uint8_t byte = *in++;
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return in;
+            }
+        }
+        return nullptr;
+    }
+}
+
+// appends records to one growable buffer: no allocation per record, only when the buffer grows
+class TransactionWriter
+{
+    private:
+        std::vector<std::uint8_t> buffer;
+        std::size_t used = 0;
+        std::int64_t previousTimeStamp = 0;
+
+    public:
+        explicit TransactionWriter(std::size_t capacityBytes = 4096) : buffer(std::max(capacityBytes, transaction_codec::headerSize))
+        {
+            clear();
+        }
+
+        // back to an empty stream (header only), keeps the capacity
+        void clear()
+        {
+            std::memcpy(buffer.data(), transaction_codec::magic, sizeof(transaction_codec::magic));
+            buffer[sizeof(transaction_codec::magic)] = transaction_codec::version;
+            used = transaction_codec::headerSize;
+            previousTimeStamp = 0;
+        }
+
+        void reserve(std::size_t records)
+        {
+            const std::size_t needed = used + records * transaction_codec::maxRecordLength;
+            if (needed > buffer.size())
+            {
+                buffer.resize(needed);
+            }
+        }
+
+        void append(TransactionType type, Money amount, std::int64_t timeStamp)
+        {
+            if (used + transaction_codec::maxRecordLength > buffer.size())
+            {
+                buffer.resize(std::max(buffer.size() * 2, used + transaction_codec::maxRecordLength));
+            }
+
+            std::uint8_t * out = buffer.data() + used;
+            *out++ = static_cast<std::uint8_t>(type);
+            out = transaction_codec::putVarint(out, transaction_codec::zigzag(amount.getCents()));
+            // two's complement wrap-around keeps any pair of timestamps round-tripping
+            const auto delta = static_cast<std::int64_t>(static_cast<std::uint64_t>(timeStamp) - static_cast<std::uint64_t>(previousTimeStamp));
+            out = transaction_codec::putVarint(out, transaction_codec::zigzag(delta));
+            previousTimeStamp = timeStamp;
+            used = static_cast<std::size_t>(out - buffer.data());
+        }
+
+        void append(const Transaction & transaction)
+        {
+            append(transaction.type, transaction.amount, transaction.timeStamp);
+        }
+
+        // encoded stream so far, valid until the next append
+        std::span<const std::uint8_t> bytes() const
+        {
+            return std::span<const std::uint8_t>(buffer.data(), used);
+        }
+
+        std::size_t size() const
+        {
+            return used;
+        }
+
+        // hands over the encoded stream, trimmed to size, && starts a new empty one
+        std::vector<std::uint8_t> release()
+        {
+            buffer.resize(used);
+            buffer.shrink_to_fit();
+            std::vector<std::uint8_t> encoded = std::move(buffer);
+            buffer.assign(transaction_codec::headerSize, 0);
+            clear();
+            return encoded;
+        }
+};
+
+// iterates records straight out of a byte buffer, nothing is copied or allocated;
+// a corrupt record ends the iteration && sets isCorrupt()
+class TransactionReader
+{
+    private:
+        std::span<const std::uint8_t> records; // after the header
+        mutable bool corrupt = false;
+
+        explicit TransactionReader(std::span<const std::uint8_t> body) : records(body) {}
+
+    public:
+        class iterator
+        {
+            private:
+                const std::uint8_t * next = nullptr; // nullptr once past the end
+                const std::uint8_t * end = nullptr;
+                const TransactionReader * reader = nullptr;
+                std::int64_t timeStamp = 0;
+                Transaction current{};
+
+                void advance()
+                {
+                    if (next == end)
+                    {
+                        next = nullptr;
+                        return;
+                    }
+
+                    std::uint64_t amount;
+                    std::uint64_t delta;
+                    const std::uint8_t type = *next;
+                    const std::uint8_t * in = transaction_codec::getVarint(next + 1, end, amount);
+                    in = (in == nullptr) ? nullptr : transaction_codec::getVarint(in, end, delta);
+                    if (in == nullptr || type >= transactionTypeCount)
+                    {
+                        reader->corrupt = true;
+                        next = nullptr;
+                        return;
+                    }
+
+                    timeStamp = static_cast<std::int64_t>(static_cast<std::uint64_t>(timeStamp) + static_cast<std::uint64_t>(transaction_codec::unzigzag(delta)));
+                    current = Transaction{static_cast<TransactionType>(type), Money::fromCents(transaction_codec::unzigzag(amount)), timeStamp};
+                    next = in;
+                }
+
+            public:
+                iterator() = default;
+
+                iterator(const TransactionReader * owner, std::span<const std::uint8_t> bytes) : next(bytes.data()), end(bytes.data() + bytes.size()), reader(owner)
+                {
+                    advance();
+                }
+
+                const Transaction & operator*() const
+                {
+                    return current;
+                }
+
+                iterator & operator++()
+                {
+                    advance();
+                    return *this;
+                }
+
+                bool operator==(const iterator & other) const
+                {
+                    return next == other.next;
+                }
+        };
+
+        // nullopt unless bytes starts with a version 1 header
+        static std::optional<TransactionReader> open(std::span<const std::uint8_t> bytes)
+        {
+            if (bytes.size() < transaction_codec::headerSize ||
+                std::memcmp(bytes.data(), transaction_codec::magic, sizeof(transaction_codec::magic)) != 0 ||
+                bytes[sizeof(transaction_codec::magic)] != transaction_codec::version)
+            {
+                return std::nullopt;
+            }
+            return TransactionReader(bytes.subspan(transaction_codec::headerSize));
+        }
+
+        iterator begin() const
+        {
+            return iterator(this, records);
+        }
+
+        iterator end() const
+        {
+            return iterator();
+        }
+
+        // true once an iteration stopped at a malformed record
+        bool isCorrupt() const
+        {
+            return corrupt;
+        }
+};
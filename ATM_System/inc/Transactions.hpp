@@ -7,13 +7,639 @@
 #include <algorithm> // sorting algorithms
 #include <ctime> // get current time
 #include <iomanip> // manipulation formating of time
+#include <cstdint> // fixed width columns
+#include <span> // read-only column views
+#include <atomic> // published history
+#include <bit> // chunk lookup
+#include <optional> // dormant histories
+#include "Money.hpp"
+#include "Transaction.hpp"
 #include "Time.hpp"
-class Transaction
+#include "AmountIndex.hpp"
+#include "AccountStats.hpp"
+#include "TransactionCodec.hpp"
+
+// one chunk of a columnar history: a fixed-size array per column, rows are written once && never move
+struct HistoryChunk
+{
+    std::unique_ptr<TransactionType[]> types;
+    std::unique_ptr<std::int64_t[]> amounts; // cents
+    std::unique_ptr<std::int64_t[]> timeStamps; // seconds since epoch
+
+    explicit HistoryChunk(std::size_t rows) : types(new TransactionType[rows]), amounts(new std::int64_t[rows]), timeStamps(new std::int64_t[rows]) {}
+
+    Transaction row(std::size_t offset) const
+    {
+        return Transaction{types[offset], Money::fromCents(amounts[offset]), timeStamps[offset]};
+    }
+};
+
+// immutable view of a history prefix && the balance it adds up to, taken without any lock
+// it shares the history's column chunks, so it stays valid (&& unchanged) for as long as it is kept
+class HistorySnapshot
+{
+    public:
+        // chunk 0 holds firstChunkSize rows, every later chunk doubles: a handful of chunks,
+        // no allocation for accounts without history && nothing ever moves once written
+        static constexpr std::size_t firstChunkSize = 16;
+        using Directory = std::vector<std::shared_ptr<HistoryChunk>>;
+
+        static std::size_t chunkOf(std::size_t position)
+        {
+            return static_cast<std::size_t>(std::bit_width(position / firstChunkSize));
+        }
+
+        static std::size_t chunkStart(std::size_t chunk)
+        {
+            return (chunk == 0) ? 0 : firstChunkSize << (chunk - 1);
+        }
+
+    private:
+        std::shared_ptr<const Directory> directory;
+        std::size_t count = 0;
+        Money balance;
+
+    public:
+        HistorySnapshot() = default;
+        HistorySnapshot(std::shared_ptr<const Directory> chunks, std::size_t size, Money ledgerBalance) : directory(std::move(chunks)), count(size), balance(ledgerBalance) {}
+
+        std::size_t size() const
+        {
+            return count;
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        // balance right after the last transaction of the snapshot
+        Money getBalance() const
+        {
+            return balance;
+        }
+
+        Transaction operator[](std::size_t position) const
+        {
+            const std::size_t chunk = chunkOf(position);
+            return (*directory)[chunk]->row(position - chunkStart(chunk));
+        }
+
+        // first position with a timestamp later than timeStamp
+        std::size_t firstAfter(std::int64_t timeStamp) const
+        {
+            std::size_t low = 0;
+            std::size_t high = count;
+            while (low < high)
+            {
+                const std::size_t middle = low + (high - low) / 2;
+                const std::size_t chunk = chunkOf(middle);
+                if ((*directory)[chunk]->timeStamps[middle - chunkStart(chunk)] <= timeStamp)
+                {
+                    low = middle + 1;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+            return low;
+        }
+};
+
+// the columns of a history, in chunks that never move: the appender writes rows past the
+// published count, (count, net) is published through a seqlock && the chunk directory through an
+// atomic shared_ptr (replaced only when a chunk is added), so snapshot readers share the columns
+// themselves, never block the appender && never see a half-applied transaction
+// a dormant history has dropped its chunks (only the net is kept) && hands out no snapshots
+// every call but snapshot() must be serialized by the caller, snapshot() may run concurrently
+class HistoryColumns
+{
+    private:
+        std::atomic<std::shared_ptr<const HistorySnapshot::Directory>> directory;
+        std::atomic<std::uint64_t> sequence{0}; // odd while count, net && dormancy are being updated
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::int64_t> netCents{0};
+        std::atomic<bool> isDormantFlag{false};
+
+        // writer-side state, guarded by the caller
+        std::shared_ptr<const HistorySnapshot::Directory> current;
+        std::size_t writerCount = 0;
+        std::size_t capacity = 0; // rows the chunks in current hold
+        std::int64_t writerNet = 0;
+        bool writerDormant = false;
+
+        // a replaced (or dropped) directory is swapped inside the write section, so no reader pairs it with another count
+        void publish(bool isDirectoryReplaced = false)
+        {
+            const std::uint64_t start = sequence.load(std::memory_order_relaxed);
+            sequence.store(start + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            count.store(writerCount, std::memory_order_relaxed);
+            netCents.store(writerNet, std::memory_order_relaxed);
+            isDormantFlag.store(writerDormant, std::memory_order_relaxed);
+            if (isDirectoryReplaced)
+            {
+                directory.store(current, std::memory_order_release);
+            }
+            sequence.store(start + 2, std::memory_order_release);
+        }
+
+        HistoryChunk & chunkAt(std::size_t position) const
+        {
+            return *(*current)[HistorySnapshot::chunkOf(position)];
+        }
+
+        void store(TransactionType type, std::int64_t amountCents, std::int64_t timeStamp)
+        {
+            reserve(writerCount + 1);
+            HistoryChunk & chunk = chunkAt(writerCount);
+            const std::size_t offset = writerCount - HistorySnapshot::chunkStart(HistorySnapshot::chunkOf(writerCount));
+            chunk.types[offset] = type;
+            chunk.amounts[offset] = amountCents;
+            chunk.timeStamps[offset] = timeStamp;
+            ++writerCount;
+        }
+
+    public:
+        // chunks for at least rows rows, published before any count that needs them
+        void reserve(std::size_t rows)
+        {
+            if (rows <= capacity)
+            {
+                return;
+            }
+            auto grown = (current == nullptr) ? std::make_shared<HistorySnapshot::Directory>() : std::make_shared<HistorySnapshot::Directory>(*current);
+            while (capacity < rows)
+            {
+                const std::size_t chunk = grown->size();
+                const std::size_t chunkSize = HistorySnapshot::chunkStart(chunk + 1) - HistorySnapshot::chunkStart(chunk);
+                grown->push_back(std::make_shared<HistoryChunk>(chunkSize));
+                capacity += chunkSize;
+            }
+            current = std::move(grown);
+            directory.store(current, std::memory_order_release);
+        }
+
+        void append(TransactionType type, std::int64_t amountCents, std::int64_t timeStamp)
+        {
+            store(type, amountCents, timeStamp);
+            writerNet += isCredit(type) ? amountCents : -amountCents;
+            publish();
+        }
+
+        void clear()
+        {
+            current.reset();
+            writerCount = 0;
+            capacity = 0;
+            writerNet = 0;
+            writerDormant = false;
+            publish(true);
+        }
+
+        // keeps the first keep rows; the chunk holding the cut is copied, so snapshots that still
+        // cover the dropped rows never see them overwritten by later appends
+        void truncate(std::size_t keep)
+        {
+            if (keep >= writerCount)
+            {
+                return;
+            }
+
+            for (std::size_t position = keep; position < writerCount; ++position)
+            {
+                const Transaction dropped = row(position);
+                writerNet -= isCredit(dropped.type) ? dropped.amount.getCents() : -dropped.amount.getCents();
+            }
+
+            const std::size_t cutChunk = HistorySnapshot::chunkOf(keep);
+            const std::size_t cutStart = HistorySnapshot::chunkStart(cutChunk);
+            auto kept = std::make_shared<HistorySnapshot::Directory>(current->begin(), current->begin() + static_cast<std::ptrdiff_t>(cutChunk));
+            if (keep != cutStart)
+            {
+                const HistoryChunk & cut = *(*current)[cutChunk];
+                auto copy = std::make_shared<HistoryChunk>(HistorySnapshot::chunkStart(cutChunk + 1) - cutStart);
+                std::copy_n(cut.types.get(), keep - cutStart, copy->types.get());
+                std::copy_n(cut.amounts.get(), keep - cutStart, copy->amounts.get());
+                std::copy_n(cut.timeStamps.get(), keep - cutStart, copy->timeStamps.get());
+                kept->push_back(std::move(copy));
+            }
+            capacity = kept->empty() ? 0 : HistorySnapshot::chunkStart(kept->size());
+            current = kept->empty() ? nullptr : std::move(kept);
+            writerCount = keep;
+            publish(true);
+        }
+
+        // drops every chunk, keeps the net; snapshots wait for restore() + wake()
+        void freeze()
+        {
+            current.reset();
+            writerCount = 0;
+            capacity = 0;
+            writerDormant = true;
+            publish(true);
+        }
+
+        // re-adds a row of a frozen history (already part of the net), nothing is published yet
+        void restore(const Transaction & row)
+        {
+            store(row.type, row.amount.getCents(), row.timeStamp);
+        }
+
+        // publishes the restored rows in one step
+        void wake()
+        {
+            writerDormant = false;
+            publish();
+        }
+
+        // writer side: rows appended so far
+        std::size_t size() const
+        {
+            return writerCount;
+        }
+
+        Transaction row(std::size_t position) const
+        {
+            return chunkAt(position).row(position - HistorySnapshot::chunkStart(HistorySnapshot::chunkOf(position)));
+        }
+
+        TransactionType typeAt(std::size_t position) const
+        {
+            return chunkAt(position).types[position - HistorySnapshot::chunkStart(HistorySnapshot::chunkOf(position))];
+        }
+
+        std::int64_t amountAt(std::size_t position) const
+        {
+            return chunkAt(position).amounts[position - HistorySnapshot::chunkStart(HistorySnapshot::chunkOf(position))];
+        }
+
+        std::int64_t timeStampAt(std::size_t position) const
+        {
+            return chunkAt(position).timeStamps[position - HistorySnapshot::chunkStart(HistorySnapshot::chunkOf(position))];
+        }
+
+        // signed sum of everything appended so far
+        std::int64_t net() const
+        {
+            return writerNet;
+        }
+
+        // nullopt while dormant
+        std::optional<HistorySnapshot> snapshot(std::int64_t openingCents) const
+        {
+            std::uint64_t start;
+            std::uint64_t size;
+            std::int64_t net;
+            bool isDormant;
+            std::shared_ptr<const HistorySnapshot::Directory> chunks;
+            do
+            {
+                start = sequence.load(std::memory_order_acquire);
+                size = count.load(std::memory_order_relaxed);
+                net = netCents.load(std::memory_order_relaxed);
+                isDormant = isDormantFlag.load(std::memory_order_relaxed);
+                // chunks are published before the count that needs them, so this directory covers size
+                chunks = directory.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_acquire);
+            } while ((start & 1) != 0 || sequence.load(std::memory_order_relaxed) != start);
+
+            if (isDormant)
+            {
+                return std::nullopt;
+            }
+            return HistorySnapshot(std::move(chunks), static_cast<std::size_t>(size), Money::fromCents(openingCents + net));
+        }
+};
+
+class TransactionRange;
+
+// columnar (struct-of-arrays) transaction history:
+// scans, sorts && sums only touch the columns they need; the columns are chunked so that
+// snapshots share them instead of a copy of every row
+// the log stays in append (chronological) order, amount queries go through byAmount
+class TransactionLog
+{
+    private:
+        HistoryColumns columns; // the only copy of a resident history, also read lock-free by snapshots
+        mutable AmountIndex<transactionTypeCount> byAmount; // mutable: built by the first amount query
+        AccountStats<transactionTypeCount> aggregates = emptyStats();
+        std::vector<std::uint8_t> packed; // dormant tier: the whole history in TransactionCodec format, empty while resident
+        std::size_t packedCount = 0;
+
+        // withdrawals && outgoing transfers both count against the withdrawal limits
+        static AccountStats<transactionTypeCount> emptyStats()
+        {
+            return AccountStats<transactionTypeCount>{static_cast<std::size_t>(TransactionType::Withdrawal), static_cast<std::size_t>(TransactionType::TransferOut)};
+        }
+
+        std::vector<Transaction> rows(const std::vector<std::uint64_t> & positions) const
+        {
+            std::vector<Transaction> result;
+            result.reserve(positions.size());
+            for (const std::uint64_t position : positions)
+            {
+                result.push_back((*this)[position]);
+            }
+            return result;
+        }
+
+        // brings the amount index up to the last row, before every amount query
+        void indexAmounts() const
+        {
+            byAmount.catchUp(columns.size(), [this](std::size_t position) { return static_cast<std::size_t>(columns.typeAt(position)); },
+                             [this](std::size_t position) { return columns.amountAt(position); });
+        }
+
+        auto amountAt() const
+        {
+            return [this](std::size_t position) { return columns.amountAt(position); };
+        }
+
+        // positions [first, last) with a timestamp <= timeStamp (strict: < timeStamp) come first
+        std::size_t partitionByTime(std::size_t first, std::size_t last, std::int64_t timeStamp, bool isStrict) const
+        {
+            while (first < last)
+            {
+                const std::size_t middle = first + (last - first) / 2;
+                const std::int64_t value = columns.timeStampAt(middle);
+                if (isStrict ? value < timeStamp : value <= timeStamp)
+                {
+                    first = middle + 1;
+                }
+                else
+                {
+                    last = middle;
+                }
+            }
+            return first;
+        }
+
+    public:
+        void append(TransactionType type, Money amount, std::int64_t timeStamp)
+        {
+            // keep the time column sorted even if the wall clock steps back
+            const std::size_t count = columns.size();
+            if (count != 0 && timeStamp < columns.timeStampAt(count - 1))
+            {
+                timeStamp = columns.timeStampAt(count - 1);
+            }
+
+            aggregates.record(static_cast<std::size_t>(type), amount.getCents(), timeStamp);
+            columns.append(type, amount.getCents(), timeStamp);
+        }
+
+        // bulk load (e.g. from a snapshot), replaces the current contents
+        void assign(std::span<const TransactionType> typeColumn, std::span<const std::int64_t> amountColumn, std::span<const std::int64_t> timeStampColumn)
+        {
+            byAmount.clear();
+            aggregates = emptyStats();
+            columns.clear();
+            packed = {};
+            packedCount = 0;
+            columns.reserve(typeColumn.size());
+            for (std::size_t i = 0; i < typeColumn.size(); ++i)
+            {
+                aggregates.record(static_cast<std::size_t>(typeColumn[i]), amountColumn[i], timeStampColumn[i]);
+                columns.append(typeColumn[i], amountColumn[i], timeStampColumn[i]);
+            }
+        }
+
+        void reserve(std::size_t capacity)
+        {
+            columns.reserve(capacity);
+        }
+
+        // room for count more entries; chunks double, so repeated batches stay amortized O(1)
+        void reserveAdditional(std::size_t count)
+        {
+            columns.reserve(columns.size() + count);
+        }
+
+        std::size_t size() const
+        {
+            return columns.size() + packedCount;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        // dormant tier: encodes the history (~6 bytes a row) && frees the columns && the amount index;
+        // totals, limits && the net keep working from the aggregates,
+        // every other accessor needs thaw() first. false if there was nothing to compress
+        bool freeze()
+        {
+            if (isDormant() || columns.size() == 0)
+            {
+                return false;
+            }
+
+            TransactionWriter writer(transaction_codec::headerSize + columns.size() * 8);
+            for (std::size_t i = 0; i < columns.size(); ++i)
+            {
+                writer.append(columns.row(i));
+            }
+            packed = writer.release();
+            packedCount = columns.size();
+
+            byAmount.clear();
+            columns.freeze();
+            return true;
+        }
+
+        // back to the resident representation; snapshot readers see the whole history appear at once
+        void thaw()
+        {
+            if (!isDormant())
+            {
+                return;
+            }
+
+            columns.reserve(packedCount);
+            const auto reader = TransactionReader::open(packed);
+            for (const Transaction & row : *reader)
+            {
+                columns.restore(row);
+            }
+            columns.wake();
+            packed = {};
+            packedCount = 0;
+        }
+
+        // visit(transaction) for every row in order; a dormant log is decoded on the fly && stays compressed
+        template <typename Visitor>
+        void forEachRow(Visitor visit) const
+        {
+            if (isDormant())
+            {
+                const auto reader = TransactionReader::open(packed);
+                for (const Transaction & row : *reader)
+                {
+                    visit(row);
+                }
+                return;
+            }
+            for (std::size_t i = 0; i < columns.size(); ++i)
+            {
+                visit(columns.row(i));
+            }
+        }
+
+        // drops every row from position keep on (a journal write that failed), resident logs only;
+        // the aggregates are rebuilt from what is left, the amount index forgets the dropped rows
+        void truncate(std::size_t keep)
+        {
+            if (keep >= columns.size())
+            {
+                return;
+            }
+
+            columns.truncate(keep);
+            byAmount.truncate(keep);
+            aggregates = emptyStats();
+            for (std::size_t i = 0; i < keep; ++i)
+            {
+                const Transaction row = columns.row(i);
+                aggregates.record(static_cast<std::size_t>(row.type), row.amount.getCents(), row.timeStamp);
+            }
+        }
+
+        bool isDormant() const
+        {
+            return packedCount != 0;
+        }
+
+        // encoded size while dormant, 0 otherwise
+        std::size_t packedBytes() const
+        {
+            return packed.size();
+        }
+
+        Transaction operator[](std::size_t position) const
+        {
+            return columns.row(position);
+        }
+
+        // first position with a timestamp later than timeStamp (the log is append-ordered by time)
+        std::size_t firstAfter(std::int64_t timeStamp) const
+        {
+            return partitionByTime(0, columns.size(), timeStamp, false);
+        }
+
+        // every transaction with from <= timeStamp <= to: two binary searches, no copies
+        TransactionRange between(std::int64_t from, std::int64_t to) const;
+
+        // running totals, O(1)
+        Money total(TransactionType type) const
+        {
+            return Money::fromCents(aggregates.getTotals(static_cast<std::size_t>(type)).sumCents);
+        }
+
+        const AccountStats<transactionTypeCount> & stats() const
+        {
+            return aggregates;
+        }
+
+        // credits minus debits over the whole log
+        std::int64_t netCents() const
+        {
+            return columns.net();
+        }
+
+        // lock-free: may be called while another thread appends; nullopt while dormant
+        std::optional<HistorySnapshot> snapshot(std::int64_t openingCents) const
+        {
+            return columns.snapshot(openingCents);
+        }
+
+        // "largest 10 withdrawals": O(k) once the rows since the last amount query are indexed
+        std::vector<Transaction> largest(TransactionType type, std::size_t k) const
+        {
+            indexAmounts();
+            return rows(byAmount.largest(static_cast<std::size_t>(type), k));
+        }
+
+        // "all deposits between X and Y" (inclusive): O(log n + matches) once indexed
+        std::vector<Transaction> inAmountRange(TransactionType type, Money low, Money high) const
+        {
+            indexAmounts();
+            return rows(byAmount.inRange(static_cast<std::size_t>(type), low.getCents(), high.getCents(), amountAt()));
+        }
+
+        std::vector<Transaction> sortedByAmount() const
+        {
+            indexAmounts();
+            return rows(byAmount.ascending(amountAt()));
+        }
+};
+
+// lightweight view of a contiguous slice of a TransactionLog
+// valid until the log is next modified
+class TransactionRange
 {
+    private:
+        const TransactionLog * log;
+        std::size_t first;
+        std::size_t last;
+
     public:
-        std::string type;
-        double amount;
-        std::string timeStamp;
+        class iterator
+        {
+            private:
+                const TransactionLog * log;
+                std::size_t position;
 
-    Transaction(std::string_view type, double amount): type(type), amount(amount), timeStamp(getCurrentTime()) {}
-};
\ No newline at end of file
+            public:
+                iterator(const TransactionLog * transactionLog, std::size_t index) : log(transactionLog), position(index) {}
+
+                Transaction operator*() const
+                {
+                    return (*log)[position];
+                }
+
+                iterator & operator++()
+                {
+                    ++position;
+                    return *this;
+                }
+
+                bool operator==(const iterator & other) const = default;
+        };
+
+        TransactionRange(const TransactionLog & transactionLog, std::size_t begin, std::size_t end) : log(&transactionLog), first(begin), last(end) {}
+
+        iterator begin() const
+        {
+            return iterator(log, first);
+        }
+
+        iterator end() const
+        {
+            return iterator(log, last);
+        }
+
+        std::size_t size() const
+        {
+            return last - first;
+        }
+
+        bool empty() const
+        {
+            return first == last;
+        }
+
+        // position of the first entry in the underlying log
+        std::size_t offset() const
+        {
+            return first;
+        }
+};
+
+inline TransactionRange TransactionLog::between(std::int64_t from, std::int64_t to) const
+{
+    const std::size_t begin = partitionByTime(0, columns.size(), from, true);
+    return TransactionRange(*this, begin, partitionByTime(begin, columns.size(), to, false));
+}
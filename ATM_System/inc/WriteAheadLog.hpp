@@ -0,0 +1,216 @@
+#pragma once
+
+#include <string> // file path, pending buffers
+#include <string_view> // lightweight string lib
+#include <cstdint> // fixed width record fields
+#include <chrono> // latency threshold
+#include <mutex> // append / flush synchronization
+#include <condition_variable> // group commit wakeups
+#include <thread> // background flusher
+#include <functional> // replay callback
+#include <span> // settlement legs
+#include <vector> // loaded log
+#include "Money.hpp"
+
+enum class WalRecordKind : std::uint8_t
+{
+    OpenAccount,
+    Deposit,
+    Withdrawal,
+    TransferIn, // settlement legs, as handed to replay callbacks
+    TransferOut,
+    Settlement, // on disk only: all legs of one transfer / netted batch, replayed all or nothing
+    LogStart // on disk only, first record of a truncated log: the sequence number the records after it continue from
+};
+
+// one account's movement inside a settlement record
+struct WalLeg
+{
+    WalRecordKind kind; // TransferIn or TransferOut
+    std::string_view accountNumber;
+    Money amount;
+};
+
+// decoded view of one log record; accountNumber points into the replay buffer
+struct WalRecord
+{
+    WalRecordKind kind;
+    std::string_view accountNumber;
+    std::int32_t pin; // OpenAccount only
+    Money amount; // initial balance for OpenAccount
+    std::int64_t timeStamp;
+    std::uint64_t lsn; // position of the record in the log (legs of a settlement share it)
+};
+
+// a run of complete log records in memory with their boundaries, for replaying records in any order
+// (e.g. split across threads); decoded records point into it, so it must outlive them
+class WalContents
+{
+    private:
+        friend class WalReader;
+
+        std::vector<char> buffer;
+        std::vector<std::size_t> offsets; // start of every record in buffer, plus the end of the last one
+        std::uint64_t start = 0; // file offset of buffer[0]
+        std::uint64_t base = 0; // lsn of the record before the first one
+
+    public:
+        std::size_t size() const
+        {
+            return offsets.empty() ? 0 : offsets.size() - 1;
+        }
+
+        // length of the log file up to the start of record (size() for the end of the last one)
+        std::uint64_t offsetOf(std::size_t record) const
+        {
+            return start + offsets[record];
+        }
+
+        // record i has lsn baseLsn() + i + 1
+        std::uint64_t baseLsn() const
+        {
+            return base;
+        }
+
+        // checks record && appends it to out (every leg for a settlement), false if it is corrupt
+        bool decode(std::size_t record, std::vector<WalRecord> & out) const;
+};
+
+// reads a log file front to back a chunk of complete records at a time, so replaying a log never
+// needs more memory than one chunk; records are checked by WalContents::decode, not here
+class WalReader
+{
+    private:
+        int fd = -1;
+        std::uint64_t fileSize = 0;
+        std::uint64_t offset = 0; // first byte not handed out yet
+        std::uint64_t nextBase = 0; // lsn of the last record handed out
+        std::uint64_t startLsn = 0;
+        std::size_t chunkBytes;
+        int readError = 0; // errno of the first failed open / read
+
+    public:
+        static constexpr std::size_t defaultChunkBytes = 16 << 20;
+
+        // an empty log if the file doesn't exist
+        explicit WalReader(const std::string & path, std::size_t chunkBytes = defaultChunkBytes);
+        ~WalReader();
+
+        WalReader(const WalReader &) = delete;
+        WalReader & operator=(const WalReader &) = delete;
+
+        // replaces chunk by the next records, about chunkBytes of them (a bigger record comes alone);
+        // false at the end of the log, a torn record at the end is never handed out,
+        // && false from the first read error on (see error())
+        bool next(WalContents & chunk);
+
+        // 0, || the errno that stopped reading: the records handed out so far are not the whole log
+        int error() const
+        {
+            return readError;
+        }
+
+        // lsn the file's records continue from (its LogStart record, 0 without one)
+        std::uint64_t baseLsn() const
+        {
+            return startLsn;
+        }
+};
+
+// where a log sequence number stands, without blocking
+enum class WalDurability : std::uint8_t
+{
+    Pending,
+    Durable,
+    Failed // the log hit an I/O error before the record was on disk, it never will be
+};
+
+// group commit thresholds: a batch is written && fsync'ed as soon as any one is reached
+struct WalConfig
+{
+    std::size_t maxBatchOps = 256;
+    std::size_t maxBatchBytes = 1 << 20;
+    std::chrono::microseconds maxLatency{1000};
+};
+
+// append-only write-ahead log with group commit
+// appenders serialize into a shared in-memory batch && get a log sequence number back,
+// a background thread writes each batch with one write() + one fdatasync()
+class WriteAheadLog
+{
+    private:
+        int fd = -1;
+        int batchEventFd = -1; // eventfd, signalled after every batch the flusher writes (or fails to)
+        WalConfig config;
+
+        std::mutex logMutex;
+        std::condition_variable flushNeeded; // wakes the flusher
+        std::condition_variable batchDurable; // wakes waitDurable()
+        std::string pending; // serialized records not yet handed to the flusher
+        std::size_t pendingOps = 0;
+        std::chrono::steady_clock::time_point oldestPending;
+        std::uint64_t appendedLsn = 0;
+        std::uint64_t durableLsn = 0;
+        std::uint64_t durableBytes = 0; // file length up to the last good batch
+        std::uint64_t baseLsn = 0; // lsn the file's records continue from (its LogStart record, 0 without one)
+        std::size_t startBytes = 0; // length of the LogStart record, 0 without one
+        std::string path;
+        bool isWriting = false; // the flusher is writing a batch with logMutex released
+        bool stopping = false;
+        bool failed = false; // sticky: set by the first write / fdatasync error
+
+        std::thread flusher;
+
+        void flushLoop();
+
+        // call with logMutex held: seals the record serialized at offset && schedules it
+        std::uint64_t commitLocked(std::size_t offset, std::size_t payloadSize);
+
+    public:
+        static constexpr std::size_t maxSettlementLegs = UINT16_MAX; // the record's leg count is 16 bits
+
+        // opens (or creates) path for appending, a torn record at the tail is truncated away;
+        // sequence numbers continue after the last intact record, so they stay valid across restarts
+        // throws std::system_error if the file cannot be opened || read (nothing is truncated then)
+        explicit WriteAheadLog(const std::string & path, WalConfig config = {});
+        ~WriteAheadLog();
+
+        WriteAheadLog(const WriteAheadLog &) = delete;
+        WriteAheadLog & operator=(const WriteAheadLog &) = delete;
+
+        // returns the record's log sequence number (never durable once the log has failed)
+        std::uint64_t append(WalRecordKind kind, std::string_view accountNumber, Money amount, std::int64_t timeStamp, std::int32_t pin = 0);
+
+        // every leg in one checksummed record, so a crash never leaves half a transfer behind;
+        // at most one leg per account (legs share the record's lsn, replay applies one record per account once)
+        // 0 (nothing logged) for more than maxSettlementLegs legs
+        std::uint64_t appendSettlement(std::span<const WalLeg> legs, std::int64_t timeStamp);
+
+        // blocks until every record up to lsn is on disk; false if lsn was not durable when the log hit
+        // its first I/O error (the log then stops writing, so every later lsn fails as well)
+        bool waitDurable(std::uint64_t lsn);
+
+        // non-blocking waitDurable, for event loops
+        WalDurability durability(std::uint64_t lsn);
+
+        // sequence number of the last record appended so far
+        std::uint64_t lastLsn();
+
+        // checkpoint: drops every record up to coveredLsn (e.g. the lsn a snapshot covers), the sequence
+        // numbers of the ones left don't change; the file is rewritten as a LogStart record + the records
+        // after coveredLsn && renamed over the log, appenders wait meanwhile
+        // false (log unchanged) if coveredLsn isn't durable yet || the log failed || the rewrite failed
+        bool truncate(std::uint64_t coveredLsn);
+
+        // readable (EPOLLIN) once a batch has been written or has failed; one consumer reads it
+        // to reset it, then checks durability() of whatever it waits for
+        int batchEventHandle() const
+        {
+            return batchEventFd;
+        }
+
+        // calls onRecord for every intact record in path (once per leg for settlements),
+        // stops at the first torn/corrupt one
+        // returns the length in bytes of the intact prefix
+        static std::size_t replay(const std::string & path, const std::function<void(const WalRecord &)> & onRecord);
+};
@@ -0,0 +1,305 @@
+#include <cstring> // memcpy, memcmp
+#include <cstdio> // rename
+#include <vector> // gathered columns
+#include <algorithm> // none_of
+#include <fcntl.h> // open
+#include <unistd.h> // write, fsync
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include "AccountSnapshot.hpp"
+#include "AccountIndex.hpp"
+#include "ATM.hpp"
+
+namespace
+{
+    constexpr char snapshotMagic[8] = {'A', 'T', 'M', 'S', 'N', 'A', 'P', '1'};
+
+    bool writeAll(int fd, const void * data, std::size_t size)
+    {
+        const auto * bytes = static_cast<const char *>(data);
+        while (size > 0)
+        {
+            const ssize_t written = ::write(fd, bytes, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    std::size_t alignUp(std::size_t size)
+    {
+        return (size + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    // claims count elements of elementSize at offset, false if they run past size (counts come from the file)
+    bool takeSection(std::size_t & offset, std::uint64_t count, std::size_t elementSize, std::size_t size)
+    {
+        if (count > (size - offset) / elementSize)
+        {
+            return false;
+        }
+        offset += static_cast<std::size_t>(count) * elementSize;
+        return true;
+    }
+}
+
+AccountSnapshot::~AccountSnapshot()
+{
+    if (mapping != nullptr)
+    {
+        ::munmap(mapping, mappingSize);
+    }
+}
+
+std::unique_ptr<AccountSnapshot> AccountSnapshot::load(const std::string & path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat fileInfo{};
+    if (::fstat(fd, &fileInfo) != 0 || static_cast<std::size_t>(fileInfo.st_size) < sizeof(SnapshotHeader))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    const auto size = static_cast<std::size_t>(fileInfo.st_size);
+    void * mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (mapped == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    // lookups jump around the index, don't let readahead pull in neighbours
+    ::madvise(mapped, size, MADV_RANDOM);
+
+    std::unique_ptr<AccountSnapshot> snapshot(new AccountSnapshot());
+    snapshot->mapping = mapped;
+    snapshot->mappingSize = size;
+
+    const auto * base = static_cast<const char *>(mapped);
+    const auto * header = reinterpret_cast<const SnapshotHeader *>(base);
+    if (std::memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) != 0 || header->version != formatVersion)
+    {
+        return nullptr;
+    }
+
+    // section starts, each count checked against what is left of the file before it is used
+    std::size_t offset = sizeof(SnapshotHeader);
+    const std::size_t accountsOffset = offset;
+    const bool hasAccounts = takeSection(offset, header->accountCount, sizeof(SnapshotAccount), size);
+    const std::size_t indexOffset = offset;
+    const bool hasIndex = hasAccounts && takeSection(offset, header->indexCapacity, sizeof(std::uint64_t), size);
+    const std::size_t amountsOffset = offset;
+    const bool hasAmounts = hasIndex && takeSection(offset, header->transactionCount, sizeof(std::int64_t), size);
+    const std::size_t timeStampsOffset = offset;
+    const bool hasTimeStamps = hasAmounts && takeSection(offset, header->transactionCount, sizeof(std::int64_t), size);
+    const std::size_t typesOffset = offset;
+    const bool hasTypes = hasTimeStamps && takeSection(offset, header->transactionCount, 1, size);
+    if (!hasTypes || header->indexCapacity <= header->accountCount || (header->indexCapacity & (header->indexCapacity - 1)) != 0)
+    {
+        return nullptr;
+    }
+
+    snapshot->header = header;
+    snapshot->accounts = reinterpret_cast<const SnapshotAccount *>(base + accountsOffset);
+    snapshot->index = reinterpret_cast<const std::uint64_t *>(base + indexOffset);
+    snapshot->amounts = reinterpret_cast<const std::int64_t *>(base + amountsOffset);
+    snapshot->timeStamps = reinterpret_cast<const std::int64_t *>(base + timeStampsOffset);
+    snapshot->types = reinterpret_cast<const TransactionType *>(base + typesOffset);
+    return snapshot;
+}
+
+bool AccountSnapshot::isIntact(const SnapshotAccount & account) const
+{
+    if (account.numberLength > SnapshotAccount::maxNumberLength || account.firstTransaction > header->transactionCount ||
+        account.transactionCount > header->transactionCount - account.firstTransaction)
+    {
+        return false;
+    }
+    // types index per-type totals once a history is materialized
+    const auto * typeBytes = reinterpret_cast<const std::uint8_t *>(types + account.firstTransaction);
+    return std::none_of(typeBytes, typeBytes + account.transactionCount, [](std::uint8_t type) { return type >= transactionTypeCount; });
+}
+
+const SnapshotAccount * AccountSnapshot::probe(std::string_view accountNumber) const
+{
+    // at most one lap: a damaged index may have no free slot to end the probe sequence
+    const std::uint64_t mask = header->indexCapacity - 1;
+    std::uint64_t i = hashAccountNumber(accountNumber) & mask;
+    for (std::uint64_t probes = 0; probes < header->indexCapacity && index[i] != 0; ++probes, i = (i + 1) & mask)
+    {
+        if (index[i] > header->accountCount)
+        {
+            return nullptr; // damaged slot
+        }
+        const SnapshotAccount & account = accounts[index[i] - 1];
+        if (account.numberLength <= SnapshotAccount::maxNumberLength && account.getAccountNumber() == accountNumber)
+        {
+            return &account;
+        }
+    }
+    return nullptr;
+}
+
+bool AccountSnapshot::write(const std::string & path, const ATM & atm)
+{
+    std::uint64_t coveredLsn;
+    return writeCovering(path, atm, coveredLsn);
+}
+
+bool AccountSnapshot::checkpoint(const std::string & path, const ATM & atm)
+{
+    std::uint64_t coveredLsn;
+    if (!writeCovering(path, atm, coveredLsn))
+    {
+        return false;
+    }
+    WriteAheadLog * journal = atm.getJournal();
+    return journal == nullptr || journal->truncate(coveredLsn);
+}
+
+bool AccountSnapshot::writeCovering(const std::string & path, const ATM & atm, std::uint64_t & coveredLsn)
+{
+    // every record appended so far is part of the state copied below: accounts journal under the same
+    // lock they change under, && the copy takes that lock after this point
+    WriteAheadLog * journal = atm.getJournal();
+    coveredLsn = (journal == nullptr) ? 0 : journal->lastLsn();
+
+    std::vector<SnapshotAccount> table;
+    std::vector<std::int64_t> amounts;
+    std::vector<std::int64_t> timeStamps;
+    std::vector<TransactionType> types;
+    bool isValid = true;
+
+    // a damaged record of the attached snapshot is missing from the copy: never publish (&& checkpoint) that
+    const bool isComplete = atm.forEachAccount([&](std::string_view accountNumber, int pin, Money balance,
+                           std::span<const TransactionType> typeColumn,
+                           std::span<const std::int64_t> amountColumn,
+                           std::span<const std::int64_t> timeStampColumn,
+                           std::uint64_t journalLsn)
+    {
+        if (accountNumber.size() > SnapshotAccount::maxNumberLength)
+        {
+            isValid = false;
+            return;
+        }
+
+        SnapshotAccount record{};
+        std::memcpy(record.number, accountNumber.data(), accountNumber.size());
+        record.numberLength = static_cast<std::uint8_t>(accountNumber.size());
+        record.pin = pin;
+        record.balanceCents = balance.getCents();
+        record.firstTransaction = amounts.size();
+        record.transactionCount = amountColumn.size();
+        record.journalLsn = journalLsn;
+        table.push_back(record);
+
+        types.insert(types.end(), typeColumn.begin(), typeColumn.end());
+        amounts.insert(amounts.end(), amountColumn.begin(), amountColumn.end());
+        timeStamps.insert(timeStamps.end(), timeStampColumn.begin(), timeStampColumn.end());
+    });
+
+    if (!isValid || !isComplete)
+    {
+        return false;
+    }
+
+    // same linear probing scheme as AccountIndex, load factor <= 1/2
+    std::uint64_t indexCapacity = 16;
+    while (indexCapacity < table.size() * 2)
+    {
+        indexCapacity *= 2;
+    }
+    std::vector<std::uint64_t> index(indexCapacity, 0);
+    for (std::size_t position = 0; position < table.size(); ++position)
+    {
+        std::uint64_t i = hashAccountNumber(table[position].getAccountNumber()) & (indexCapacity - 1);
+        while (index[i] != 0)
+        {
+            i = (i + 1) & (indexCapacity - 1);
+        }
+        index[i] = position + 1;
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = formatVersion;
+    header.accountCount = table.size();
+    header.indexCapacity = indexCapacity;
+    header.transactionCount = amounts.size();
+    header.journalLsn = coveredLsn;
+
+    const std::string temporaryPath = path + ".tmp";
+    const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    const char padding[8] = {};
+    const bool isWritten =
+        writeAll(fd, &header, sizeof(header)) &&
+        writeAll(fd, table.data(), table.size() * sizeof(SnapshotAccount)) &&
+        writeAll(fd, index.data(), index.size() * sizeof(std::uint64_t)) &&
+        writeAll(fd, amounts.data(), amounts.size() * sizeof(std::int64_t)) &&
+        writeAll(fd, timeStamps.data(), timeStamps.size() * sizeof(std::int64_t)) &&
+        writeAll(fd, types.data(), types.size()) &&
+        writeAll(fd, padding, alignUp(types.size()) - types.size()) &&
+        ::fsync(fd) == 0;
+    ::close(fd);
+
+    // accounts may have changed while they were copied: never publish state the journal could still lose
+    const bool isDurable = (journal == nullptr) || journal->waitDurable(journal->lastLsn());
+    if (!isWritten || !isDurable || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        ::unlink(temporaryPath.c_str());
+        return false;
+    }
+
+    // the rename must be on disk before a checkpoint drops the journal records behind it
+    const std::size_t slash = path.rfind('/');
+    const std::string directory = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    const int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directoryFd < 0)
+    {
+        return false;
+    }
+    const bool isSynced = ::fsync(directoryFd) == 0;
+    ::close(directoryFd);
+    return isSynced;
+}
+
+SnapshotWriter::SnapshotWriter(const ATM & atm, std::string path, std::chrono::seconds interval)
+    : worker([this, &atm, path = std::move(path), interval](std::stop_token stopToken)
+    {
+        std::unique_lock lock(waitMutex);
+        while (true)
+        {
+            wakeUp.wait_for(lock, stopToken, interval, [] { return false; });
+            if (stopToken.stop_requested())
+            {
+                return;
+            }
+
+            lock.unlock();
+            if (!AccountSnapshot::checkpoint(path, atm))
+            {
+                std::cout << "Checkpoint to " << path << " failed!\n";
+            }
+            lock.lock();
+        }
+    })
+{
+}
@@ -0,0 +1,335 @@
+#include <cstring> // memcpy, memcmp, memset
+#include <bit> // bit_ceil, has_single_bit, countr_zero
+#include <algorithm> // max
+#include <utility> // exchange
+#include <cstddef> // offsetof
+#include <system_error> // open failures
+#include <fcntl.h> // open
+#include <unistd.h> // pread, pwrite, fdatasync
+#include <sys/stat.h> // fstat
+#include "AccountStore.hpp"
+
+namespace
+{
+    constexpr char storeMagic[8] = {'A', 'T', 'M', 'S', 'T', 'O', 'R', '1'};
+    constexpr std::size_t minimumSlot = 64;
+
+    bool readAll(int fd, void * data, std::size_t size, std::uint64_t offset)
+    {
+        auto * bytes = static_cast<char *>(data);
+        while (size > 0)
+        {
+            const ssize_t got = ::pread(fd, bytes, size, static_cast<off_t>(offset));
+            if (got < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (got <= 0)
+            {
+                return false;
+            }
+            bytes += got;
+            size -= static_cast<std::size_t>(got);
+            offset += static_cast<std::uint64_t>(got);
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const void * data, std::size_t size, std::uint64_t offset)
+    {
+        const auto * bytes = static_cast<const char *>(data);
+        while (size > 0)
+        {
+            const ssize_t written = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<std::size_t>(written);
+            offset += static_cast<std::uint64_t>(written);
+        }
+        return true;
+    }
+
+    // FNV-1a, as in the write-ahead log
+    std::uint32_t checksum(const std::uint8_t * data, std::size_t size)
+    {
+        std::uint32_t hash = 2166136261U;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= data[i];
+            hash *= 16777619U;
+        }
+        return hash;
+    }
+
+    // record: a whole record (header, number && history) as read from its slot; the stored checksum
+    // is zeroed in place, as it was when the record was sealed
+    bool hasValidChecksum(std::vector<std::uint8_t> & record)
+    {
+        std::uint32_t stored;
+        std::memcpy(&stored, record.data() + offsetof(StoreRecord, checksum), sizeof(stored));
+        std::memset(record.data() + offsetof(StoreRecord, checksum), 0, sizeof(stored));
+        return checksum(record.data(), record.size()) == stored;
+    }
+}
+
+AccountStore::AccountStore(const std::string & path) : freeSlots(32)
+{
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "AccountStore: cannot open " + path);
+    }
+
+    struct stat fileInfo{};
+    if (::fstat(fd, &fileInfo) != 0)
+    {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "AccountStore: cannot stat " + path);
+    }
+    const auto fileSize = static_cast<std::uint64_t>(fileInfo.st_size);
+
+    StoreHeader header{};
+    fileEnd = minimumSlot;
+    if (fileSize == 0)
+    {
+        std::memcpy(header.magic, storeMagic, sizeof(storeMagic));
+        header.version = formatVersion;
+        if (!writeAll(fd, &header, sizeof(header), 0))
+        {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "AccountStore: cannot initialize " + path);
+        }
+        return;
+    }
+    if (!readAll(fd, &header, sizeof(header), 0) || std::memcmp(header.magic, storeMagic, sizeof(storeMagic)) != 0 || header.version != formatVersion)
+    {
+        ::close(fd);
+        throw std::system_error(EINVAL, std::generic_category(), "AccountStore: " + path + " is not an account store");
+    }
+
+    // a slot that doesn't hold an intact record is skipped one alignment step at a time,
+    // the next intact one starts on a later boundary
+    std::uint64_t offset = minimumSlot;
+    while (offset + sizeof(StoreRecord) <= fileSize)
+    {
+        StoreRecord record{};
+        bool isIntact = readAll(fd, &record, sizeof(record), offset) && std::has_single_bit(record.capacity) && record.capacity >= minimumSlot &&
+                        record.historyBytes <= record.capacity && sizeof(StoreRecord) + record.numberLength + record.historyBytes <= record.capacity &&
+                        offset + sizeof(StoreRecord) + record.numberLength + record.historyBytes <= fileSize;
+        if (isIntact)
+        {
+            scratch.resize(sizeof(StoreRecord) + record.numberLength + record.historyBytes);
+            isIntact = readAll(fd, scratch.data(), scratch.size(), offset) && hasValidChecksum(scratch);
+        }
+        if (!isIntact)
+        {
+            deadBytes += minimumSlot;
+            offset += minimumSlot;
+            continue;
+        }
+
+        const std::string_view accountNumber(reinterpret_cast<const char *>(scratch.data()) + sizeof(StoreRecord), record.numberLength);
+        const Location location{offset, record.capacity, record.generation};
+        nextGeneration = std::max(nextGeneration, record.generation + 1);
+        if (index.insert(accountNumber, numbers.size(), keyAt()))
+        {
+            numbers.emplace_back(accountNumber);
+            locations.push_back(location);
+        }
+        else
+        {
+            // an older copy: the newer generation wins, the other slot is reusable once the winner is synced
+            const std::size_t position = index.find(accountNumber, keyAt());
+            Location & current = locations[position];
+            retiredSlots.push_back((current.generation < location.generation) ? std::exchange(current, location) : location);
+            deadBytes += retiredSlots.back().capacity;
+        }
+        offset += record.capacity;
+    }
+    // a torn last record may still have bytes past its slot start: new slots begin after all of them
+    fileEnd = std::max(offset, (fileSize + minimumSlot - 1) / minimumSlot * minimumSlot);
+}
+
+AccountStore::~AccountStore()
+{
+    ::close(fd);
+}
+
+std::size_t AccountStore::encodeLocked(const Account & account)
+{
+    StoreRecord record{};
+    account.exportState([&](int PIN, Money balance, const TransactionLog & log, std::uint64_t journalLsn)
+    {
+        history.clear();
+        history.reserve(log.size());
+        log.forEachRow([&](const Transaction & row) { history.append(row); });
+        record.pin = PIN;
+        record.balanceCents = balance.getCents();
+        record.journalLsn = journalLsn;
+    });
+
+    const WithdrawalLimits limits = account.getWithdrawalLimits();
+    record.dailyLimitCents = limits.daily.getCents();
+    record.monthlyLimitCents = limits.monthly.getCents();
+
+    const std::string_view accountNumber = account.getAccountNumber();
+    record.numberLength = static_cast<std::uint8_t>(accountNumber.size());
+    record.historyBytes = history.size();
+
+    const std::size_t recordSize = sizeof(StoreRecord) + accountNumber.size() + history.size();
+    scratch.resize(recordSize);
+    std::memcpy(scratch.data(), &record, sizeof(record));
+    std::memcpy(scratch.data() + sizeof(record), accountNumber.data(), accountNumber.size());
+    std::memcpy(scratch.data() + sizeof(record) + accountNumber.size(), history.bytes().data(), history.size());
+    return recordSize;
+}
+
+std::uint64_t AccountStore::claimSlotLocked(std::uint32_t capacity)
+{
+    std::vector<std::uint64_t> & free = freeSlots[static_cast<std::size_t>(std::countr_zero(capacity))];
+    if (free.empty())
+    {
+        const std::uint64_t offset = fileEnd;
+        fileEnd += capacity;
+        return offset;
+    }
+    const std::uint64_t offset = free.back();
+    free.pop_back();
+    deadBytes -= capacity;
+    return offset;
+}
+
+bool AccountStore::writeLocked(std::size_t position, std::string_view accountNumber, std::size_t recordSize)
+{
+    // same size class while the record still fits, so the account keeps reusing its own old slots;
+    // a grown record gets room to grow again: histories only ever get longer
+    const bool isFitting = position != AccountIndex::npos && recordSize <= locations[position].capacity;
+    const Location location{0, isFitting ? locations[position].capacity : static_cast<std::uint32_t>(std::bit_ceil(std::max(recordSize * 2, minimumSlot))), nextGeneration};
+
+    auto * record = reinterpret_cast<StoreRecord *>(scratch.data());
+    record->capacity = location.capacity;
+    record->generation = location.generation;
+    record->checksum = 0;
+    record->checksum = checksum(scratch.data(), recordSize);
+
+    const Location written{claimSlotLocked(location.capacity), location.capacity, location.generation};
+    if (!writeAll(fd, scratch.data(), recordSize, written.offset))
+    {
+        // a partly written record fails its checksum, the current one is untouched: the slot is free again
+        freeSlots[static_cast<std::size_t>(std::countr_zero(written.capacity))].push_back(written.offset);
+        deadBytes += written.capacity;
+        return false;
+    }
+    ++nextGeneration;
+
+    if (position == AccountIndex::npos)
+    {
+        index.insert(accountNumber, numbers.size(), keyAt());
+        numbers.emplace_back(accountNumber);
+        locations.push_back(written);
+        return true;
+    }
+
+    // the old record stays intact until a sync() has the new one on disk
+    retiredSlots.push_back(std::exchange(locations[position], written));
+    deadBytes += retiredSlots.back().capacity;
+    return true;
+}
+
+bool AccountStore::add(const Account & account)
+{
+    if (account.getAccountNumber().size() > maxNumberLength)
+    {
+        return false;
+    }
+
+    std::lock_guard lock(storeMutex);
+    if (index.find(account.getAccountNumber(), keyAt()) != AccountIndex::npos)
+    {
+        return false;
+    }
+    return writeLocked(AccountIndex::npos, account.getAccountNumber(), encodeLocked(account));
+}
+
+bool AccountStore::save(const Account & account)
+{
+    std::lock_guard lock(storeMutex);
+    const std::size_t position = index.find(account.getAccountNumber(), keyAt());
+    return (position != AccountIndex::npos) && writeLocked(position, account.getAccountNumber(), encodeLocked(account));
+}
+
+std::unique_ptr<Account> AccountStore::load(std::string_view accountNumber) const
+{
+    std::vector<TransactionType> types;
+    std::vector<std::int64_t> amounts;
+    std::vector<std::int64_t> timeStamps;
+    StoreRecord record{};
+    {
+        std::lock_guard lock(storeMutex);
+        const std::size_t position = index.find(accountNumber, keyAt());
+        if (position == AccountIndex::npos || !readAll(fd, &record, sizeof(record), locations[position].offset) ||
+            sizeof(StoreRecord) + record.numberLength + record.historyBytes > record.capacity)
+        {
+            return nullptr;
+        }
+
+        scratch.resize(sizeof(StoreRecord) + record.numberLength + record.historyBytes);
+        if (!readAll(fd, scratch.data(), scratch.size(), locations[position].offset) || !hasValidChecksum(scratch))
+        {
+            return nullptr;
+        }
+
+        const auto reader = TransactionReader::open(std::span<const std::uint8_t>(scratch).subspan(sizeof(StoreRecord) + record.numberLength));
+        if (!reader)
+        {
+            return nullptr;
+        }
+        for (const Transaction & row : *reader)
+        {
+            types.push_back(row.type);
+            amounts.push_back(row.amount.getCents());
+            timeStamps.push_back(row.timeStamp);
+        }
+        if (reader->isCorrupt())
+        {
+            return nullptr;
+        }
+    }
+
+    auto account = std::make_unique<Account>(accountNumber, record.pin, Money::fromCents(record.balanceCents));
+    account->loadHistory(types, amounts, timeStamps);
+    account->setWithdrawalLimits(WithdrawalLimits{Money::fromCents(record.dailyLimitCents), Money::fromCents(record.monthlyLimitCents)});
+    account->setJournalLsn(record.journalLsn);
+    return account;
+}
+
+bool AccountStore::sync()
+{
+    // records saved before this point are on disk afterwards, so the slots they replaced can be reused
+    std::size_t retiredCount;
+    {
+        std::lock_guard lock(storeMutex);
+        retiredCount = retiredSlots.size();
+    }
+    if (::fdatasync(fd) != 0)
+    {
+        return false;
+    }
+
+    std::lock_guard lock(storeMutex);
+    for (std::size_t i = 0; i < retiredCount; ++i)
+    {
+        freeSlots[static_cast<std::size_t>(std::countr_zero(retiredSlots[i].capacity))].push_back(retiredSlots[i].offset);
+    }
+    retiredSlots.erase(retiredSlots.begin(), retiredSlots.begin() + static_cast<std::ptrdiff_t>(retiredCount));
+    return true;
+}
@@ -0,0 +1,261 @@
+#include <cstring> // memcpy, memcmp
+#include <mutex> // segment creation
+#include <new> // placement new
+#include <system_error> // publish failures
+#include <fcntl.h> // O_* flags
+#include <unistd.h> // ftruncate, close
+#include <sys/mman.h> // mmap, shm_open
+#include <sys/stat.h> // fstat
+#include "Metrics.hpp"
+
+namespace
+{
+    constexpr char metricsMagic[8] = {'A', 'T', 'M', 'M', 'E', 'T', 'R', '1'};
+    constexpr std::size_t slotsOffset = (sizeof(MetricsHeader) + alignof(MetricsSlot) - 1) & ~(alignof(MetricsSlot) - 1);
+    constexpr std::size_t segmentSize = slotsOffset + sizeof(MetricsSlot) * Metrics::maxThreads;
+
+    std::mutex segmentMutex;
+    std::atomic<MetricsSlot *> segmentSlots{nullptr};
+    double segmentTicksPerNanosecond = 1.0;
+
+    // hands the slot back when its thread exits; the counts stay && keep accumulating for the next owner
+    struct SlotRelease
+    {
+        MetricsSlot * claimed = nullptr;
+
+        ~SlotRelease()
+        {
+            if (claimed != nullptr && claimed->isShared == 0)
+            {
+                claimed->owner.store(0, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local SlotRelease slotRelease;
+
+    double calibrateTicks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint64_t startTicks = readTicks();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(5))
+        {
+        }
+        const std::uint64_t ticks = readTicks() - startTicks;
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        return static_cast<double>(ticks) / elapsed.count();
+#else
+        return 1.0;
+#endif
+    }
+
+    // call with segmentMutex held: lays out header && slots in fresh zeroed memory
+    void initializeSegment(void * memory)
+    {
+        auto * header = new (memory) MetricsHeader{};
+        std::memcpy(header->magic, metricsMagic, sizeof(metricsMagic));
+        header->version = Metrics::formatVersion;
+        header->slotCount = Metrics::maxThreads;
+        header->opCount = metricOpCount;
+        header->bucketCount = metricBucketCount;
+        header->ticksPerNanosecond = segmentTicksPerNanosecond = calibrateTicks();
+
+        auto * slots = new (static_cast<char *>(memory) + slotsOffset) MetricsSlot[Metrics::maxThreads];
+        slots[Metrics::maxThreads - 1].isShared = 1;
+        segmentSlots.store(slots, std::memory_order_release);
+    }
+
+    MetricsSlot * ensureSegment()
+    {
+        if (MetricsSlot * slots = segmentSlots.load(std::memory_order_acquire))
+        {
+            return slots;
+        }
+
+        std::lock_guard lock(segmentMutex);
+        if (segmentSlots.load(std::memory_order_relaxed) == nullptr)
+        {
+            // nobody published: keep the counters in private memory, still readable in-process
+            void * memory = ::mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED)
+            {
+                throw std::system_error(errno, std::generic_category(), "Metrics: cannot map counters");
+            }
+            initializeSegment(memory);
+        }
+        return segmentSlots.load(std::memory_order_relaxed);
+    }
+
+    OperationSummary summarizeSlots(const MetricsSlot * slots, std::size_t slotCount, MetricOp op, double ticksPerNanosecond)
+    {
+        OperationSummary summary;
+        std::uint64_t ticks = 0;
+        for (std::size_t i = 0; i < slotCount; ++i)
+        {
+            const OperationCounters & counters = slots[i].operations[static_cast<std::size_t>(op)];
+            summary.count += counters.count.load(std::memory_order_relaxed);
+            summary.failures += counters.failures.load(std::memory_order_relaxed);
+            ticks += counters.ticks.load(std::memory_order_relaxed);
+            for (std::size_t bucket = 0; bucket < metricBucketCount; ++bucket)
+            {
+                summary.buckets[bucket] += counters.buckets[bucket].load(std::memory_order_relaxed);
+            }
+        }
+        if (summary.count != 0)
+        {
+            summary.meanNanoseconds = static_cast<double>(ticks) / static_cast<double>(summary.count) / ticksPerNanosecond;
+        }
+        return summary;
+    }
+}
+
+double OperationSummary::percentileNanoseconds(double quantile, double ticksPerNanosecond) const
+{
+    // counters are read one by one while writers keep going, so rank against the buckets themselves
+    std::uint64_t total = 0;
+    for (const std::uint64_t bucketCount : buckets)
+    {
+        total += bucketCount;
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    const auto rank = static_cast<std::uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+    std::uint64_t seen = 0;
+    std::size_t bucket = 0;
+    for (; bucket < metricBucketCount - 1; ++bucket)
+    {
+        seen += buckets[bucket];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+    const double upperTicks = (bucket == 0) ? 0.0 : static_cast<double>((std::uint64_t{1} << bucket) - 1);
+    return upperTicks / ticksPerNanosecond;
+}
+
+MetricsSlot * Metrics::claimSlot()
+{
+    MetricsSlot * slots = ensureSegment();
+    for (std::uint32_t i = 0; i + 1 < maxThreads; ++i)
+    {
+        std::uint32_t expected = 0;
+        if (slots[i].owner.load(std::memory_order_relaxed) == 0 &&
+            slots[i].owner.compare_exchange_strong(expected, 1, std::memory_order_acquire))
+        {
+            slotRelease.claimed = slot = &slots[i];
+            return slot;
+        }
+    }
+    return slot = &slots[maxThreads - 1];
+}
+
+void Metrics::publish(const std::string & name)
+{
+    std::lock_guard lock(segmentMutex);
+    if (segmentSlots.load(std::memory_order_relaxed) != nullptr)
+    {
+        throw std::system_error(EEXIST, std::generic_category(), "Metrics: counters are already in use, publish before the first operation");
+    }
+
+    // never take over a segment that is already there: it may belong to a running process
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Metrics: cannot create " + name);
+    }
+    if (::ftruncate(fd, static_cast<off_t>(segmentSize)) != 0)
+    {
+        const int error = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::system_error(error, std::generic_category(), "Metrics: cannot size " + name);
+    }
+
+    void * memory = ::mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+    ::close(fd); // the mapping keeps the object alive
+    if (memory == MAP_FAILED)
+    {
+        ::shm_unlink(name.c_str());
+        throw std::system_error(error, std::generic_category(), "Metrics: cannot map " + name);
+    }
+    initializeSegment(memory);
+}
+
+std::string Metrics::segmentName(long pid)
+{
+    return "/atm_metrics." + std::to_string(pid);
+}
+
+void Metrics::unpublish(const std::string & name)
+{
+    ::shm_unlink(name.c_str());
+}
+
+OperationSummary Metrics::summarize(MetricOp op)
+{
+    const MetricsSlot * slots = segmentSlots.load(std::memory_order_acquire);
+    return (slots == nullptr) ? OperationSummary{} : summarizeSlots(slots, maxThreads, op, segmentTicksPerNanosecond);
+}
+
+double Metrics::ticksPerNanosecond()
+{
+    ensureSegment();
+    return segmentTicksPerNanosecond;
+}
+
+MetricsReader::~MetricsReader()
+{
+    if (mapping != nullptr)
+    {
+        ::munmap(mapping, mappingSize);
+    }
+}
+
+std::unique_ptr<MetricsReader> MetricsReader::open(const std::string & name)
+{
+    const int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat objectInfo{};
+    if (::fstat(fd, &objectInfo) != 0 || static_cast<std::size_t>(objectInfo.st_size) < segmentSize)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    void * mapped = ::mmap(nullptr, segmentSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<MetricsReader> reader(new MetricsReader());
+    reader->mapping = mapped;
+    reader->mappingSize = segmentSize;
+
+    const auto * header = static_cast<const MetricsHeader *>(mapped);
+    if (std::memcmp(header->magic, metricsMagic, sizeof(metricsMagic)) != 0 || header->version != Metrics::formatVersion ||
+        header->slotCount != Metrics::maxThreads || header->opCount != metricOpCount || header->bucketCount != metricBucketCount)
+    {
+        return nullptr;
+    }
+
+    reader->header = header;
+    reader->slots = reinterpret_cast<const MetricsSlot *>(static_cast<const char *>(mapped) + slotsOffset);
+    return reader;
+}
+
+OperationSummary MetricsReader::summarize(MetricOp op) const
+{
+    return summarizeSlots(slots, header->slotCount, op, header->ticksPerNanosecond);
+}
@@ -0,0 +1,429 @@
+#include <cstring> // strerror
+#include <system_error> // setup failures
+#include <charconv> // from_chars
+#include <utility> // exchange
+#include <sys/epoll.h> // event loop
+#include <sys/eventfd.h> // stop wakeup
+#include <sys/socket.h> // socket, accept4
+#include <sys/un.h> // sockaddr_un
+#include <unistd.h> // read, write, close
+#include "SessionServer.hpp"
+#include "CommandTable.hpp"
+
+namespace
+{
+    // closes the connection when the session coroutine ends or is destroyed
+    class SocketGuard
+    {
+        private:
+            int fd;
+
+        public:
+            explicit SocketGuard(int socketFd) : fd(socketFd) {}
+            ~SocketGuard() { ::close(fd); }
+            SocketGuard(const SocketGuard &) = delete;
+            SocketGuard & operator=(const SocketGuard &) = delete;
+    };
+
+    void appendBalance(std::string & out, Money balance)
+    {
+        char text[Money::maxFormattedLength];
+        out += "OK ";
+        out.append(text, balance.format(text, text + sizeof(text)));
+        out += '\n';
+    }
+
+    struct SessionContext
+    {
+        ATM & atm;
+        AccountHandle & current;
+        std::string & out;
+        AccountLease & deferredAccount;
+        Operation & deferredOperation;
+    };
+
+    void appendResult(std::string & out, OperationResult result, Money balance)
+    {
+        if (result == OperationResult::Applied)
+        {
+            appendBalance(out, balance);
+        }
+        else
+        {
+            out += "ERR ";
+            out += toString(result);
+            out += '\n';
+        }
+    }
+
+    // resolves the logged-in account or answers "not logged in"
+    AccountLease loggedIn(SessionContext & session, AccessMode mode)
+    {
+        AccountLease account = session.atm.acquire(session.current, mode);
+        if (!account)
+        {
+            session.out += "ERR not logged in\n";
+        }
+        return account;
+    }
+
+    // the session applies it once the line is handled, so it can wait for the journal without blocking
+    void deferOperation(SessionContext & session, TransactionType type, Money amount)
+    {
+        if (AccountLease account = loggedIn(session, AccessMode::Write))
+        {
+            session.deferredAccount = std::move(account);
+            session.deferredOperation = Operation{type, amount};
+        }
+    }
+
+    constexpr CommandTable<SessionContext, 5> sessionCommands({{
+        {"LOGIN", ArgumentKind::Credentials, [](SessionContext & session, const ParsedArguments & arguments)
+        {
+            session.current = session.atm.tryAuthenticate(arguments.accountNumber, arguments.pin);
+            session.out += session.current ? "OK\n" : "ERR authentication failed\n";
+        }},
+        {"DEPOSIT", ArgumentKind::Amount, [](SessionContext & session, const ParsedArguments & arguments)
+        {
+            deferOperation(session, TransactionType::Deposit, arguments.amount);
+        }},
+        {"WITHDRAW", ArgumentKind::Amount, [](SessionContext & session, const ParsedArguments & arguments)
+        {
+            deferOperation(session, TransactionType::Withdrawal, arguments.amount);
+        }},
+        {"BALANCE", ArgumentKind::None, [](SessionContext & session, const ParsedArguments &)
+        {
+            if (const AccountLease account = loggedIn(session, AccessMode::Read))
+            {
+                appendBalance(session.out, account->getBalance());
+            }
+        }},
+        {"QUIT", ArgumentKind::None, [](SessionContext & session, const ParsedArguments &)
+        {
+            session.out += "BYE\n";
+        }},
+    }});
+
+    // epoll tags: sockets are tagged with their fd, the journal's batch eventfd && the stop() eventfd
+    // with values no fd can have
+    constexpr std::uint64_t journalEventTag = ~std::uint64_t{0};
+    constexpr std::uint64_t wakeEventTag = ~std::uint64_t{0} - 1;
+
+    [[noreturn]] void throwErrno(const char * what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+}
+
+SessionServer::SessionServer(ATM & servedAtm, std::string path) : atm(servedAtm), journal(servedAtm.getJournal()), socketPath(std::move(path))
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        throw std::system_error(ENAMETOOLONG, std::generic_category(), "SessionServer: socket path too long");
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    ::unlink(socketPath.c_str()); // stale socket from a previous run
+
+    // the destructor doesn't run for a constructor that throws: give back what was set up so far
+    try
+    {
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0)
+        {
+            throwErrno("SessionServer: socket");
+        }
+        if (::bind(listenFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            throwErrno("SessionServer: bind");
+        }
+        isBound = true;
+        if (::listen(listenFd, SOMAXCONN) != 0)
+        {
+            throwErrno("SessionServer: listen");
+        }
+
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0)
+        {
+            throwErrno("SessionServer: epoll_create1");
+        }
+        wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0)
+        {
+            throwErrno("SessionServer: eventfd");
+        }
+        epoll_event wakeEvent{};
+        wakeEvent.events = EPOLLIN;
+        wakeEvent.data.u64 = wakeEventTag;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wakeEvent) != 0)
+        {
+            throwErrno("SessionServer: epoll_ctl (wakeup)");
+        }
+
+        if (journal != nullptr)
+        {
+            epoll_event batchEvent{};
+            batchEvent.events = EPOLLIN;
+            batchEvent.data.u64 = journalEventTag;
+            if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, journal->batchEventHandle(), &batchEvent) != 0)
+            {
+                throwErrno("SessionServer: epoll_ctl (journal)");
+            }
+        }
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+}
+
+void SessionServer::release()
+{
+    for (int * fd : {&wakeFd, &epollFd, &listenFd})
+    {
+        if (*fd >= 0)
+        {
+            ::close(std::exchange(*fd, -1));
+        }
+    }
+    if (std::exchange(isBound, false))
+    {
+        ::unlink(socketPath.c_str());
+    }
+}
+
+SessionServer::~SessionServer()
+{
+    // coroutines still parked on a socket: destroying a session frame closes its connection
+    for (auto & [fd, handle] : suspended)
+    {
+        handle.destroy();
+    }
+    for (auto & [lsn, handle] : awaitingDurable)
+    {
+        handle.destroy();
+    }
+    if (journal != nullptr)
+    {
+        ::epoll_ctl(epollFd, EPOLL_CTL_DEL, journal->batchEventHandle(), nullptr);
+    }
+    release();
+}
+
+SessionServer::ReadyAwaiter SessionServer::readable(int fd)
+{
+    return ReadyAwaiter{*this, fd, EPOLLIN};
+}
+
+SessionServer::ReadyAwaiter SessionServer::writable(int fd)
+{
+    return ReadyAwaiter{*this, fd, EPOLLOUT};
+}
+
+SessionServer::DurableAwaiter SessionServer::durable(std::uint64_t lsn)
+{
+    return DurableAwaiter{*this, lsn};
+}
+
+void SessionServer::resumeDurable()
+{
+    std::uint64_t batches;
+    [[maybe_unused]] const ssize_t isReset = ::read(journal->batchEventHandle(), &batches, sizeof(batches));
+
+    // lowest lsn first: once one is still pending, so is every later one
+    while (!awaitingDurable.empty() && journal->durability(awaitingDurable.begin()->first) != WalDurability::Pending)
+    {
+        const std::coroutine_handle<> handle = awaitingDurable.begin()->second;
+        awaitingDurable.erase(awaitingDurable.begin());
+        handle.resume();
+    }
+}
+
+void SessionServer::watch(int fd, std::uint32_t events, std::coroutine_handle<> handle)
+{
+    epoll_event event{};
+    event.events = events | EPOLLONESHOT | EPOLLRDHUP;
+    event.data.u64 = static_cast<std::uint64_t>(fd);
+    if (::epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) != 0)
+    {
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+    suspended[fd] = handle;
+}
+
+void SessionServer::run()
+{
+    acceptLoop();
+
+    epoll_event events[256];
+    while (!stopping.load(std::memory_order_acquire))
+    {
+        const int ready = ::epoll_wait(epollFd, events, 256, -1);
+        for (int i = 0; i < ready; ++i)
+        {
+            if (events[i].data.u64 == wakeEventTag)
+            {
+                continue; // stop() wakeup, the loop condition handles it
+            }
+            if (events[i].data.u64 == journalEventTag)
+            {
+                resumeDurable();
+                continue;
+            }
+
+            const auto found = suspended.find(static_cast<int>(events[i].data.u64));
+            if (found != suspended.end())
+            {
+                const std::coroutine_handle<> handle = found->second;
+                suspended.erase(found);
+                handle.resume();
+            }
+        }
+    }
+}
+
+void SessionServer::stop()
+{
+    stopping.store(true, std::memory_order_release);
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = ::write(wakeFd, &one, sizeof(one));
+}
+
+SessionServer::DetachedTask SessionServer::acceptLoop()
+{
+    while (true)
+    {
+        const int client = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client >= 0)
+        {
+            session(client);
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            co_await readable(listenFd);
+        }
+        else if (errno != EINTR && errno != ECONNABORTED)
+        {
+            std::cout << "Session server: accept failed: " << std::strerror(errno) << "\n";
+            co_return;
+        }
+    }
+}
+
+SessionServer::DetachedTask SessionServer::session(int fd)
+{
+    SocketGuard guard(fd);
+    AccountHandle current;
+    DeferredOperation deferred;
+    std::string input;
+    std::string output;
+    char chunk[4096];
+
+    while (true)
+    {
+        const ssize_t received = ::read(fd, chunk, sizeof(chunk));
+        if (received == 0)
+        {
+            co_return; // peer closed
+        }
+        if (received < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                co_await readable(fd);
+                continue;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            co_return;
+        }
+        input.append(chunk, static_cast<std::size_t>(received));
+
+        // answer every complete line (requests may be pipelined)
+        std::size_t consumed = 0;
+        bool isClosing = false;
+        for (std::size_t newline; !isClosing && (newline = input.find('\n', consumed)) != std::string::npos; consumed = newline + 1)
+        {
+            std::string_view line(input.data() + consumed, newline - consumed);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+            if (line.size() > maxLineLength)
+            {
+                output += "ERR line too long\n";
+                isClosing = true;
+                break;
+            }
+            isClosing = (line == "QUIT");
+            handleLine(line, current, output, deferred);
+            if (deferred.account)
+            {
+                // answered only once durable; other sessions run meanwhile, the lease keeps the account resident
+                const AccountLease account = std::move(deferred.account);
+                MetricTimer timer((deferred.operation.type == TransactionType::Deposit) ? MetricOp::Deposite : MetricOp::Withdraw);
+                PendingBatch batch = account->beginBatch(std::span(&deferred.operation, 1));
+                const bool isDurable = co_await durable(batch.lsn);
+                const OperationResult result = account->finishBatch(batch, isDurable).front();
+                if (result != OperationResult::Applied)
+                {
+                    timer.failed();
+                }
+                appendResult(output, result, account->getBalance());
+            }
+        }
+        input.erase(0, consumed);
+        if (!isClosing && input.size() > maxLineLength + 1)
+        {
+            // no newline in sight (+ 1 for a '\r' of a line that is still arriving): don't buffer an unbounded line
+            output += "ERR line too long\n";
+            isClosing = true;
+        }
+
+        std::size_t sent = 0;
+        while (sent < output.size())
+        {
+            // MSG_NOSIGNAL: a client that hung up is an EPIPE for its session, not a SIGPIPE for the server
+            const ssize_t written = ::send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+            if (written >= 0)
+            {
+                sent += static_cast<std::size_t>(written);
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                co_await writable(fd);
+            }
+            else if (errno != EINTR)
+            {
+                co_return;
+            }
+        }
+        output.clear();
+
+        if (isClosing)
+        {
+            co_return;
+        }
+    }
+}
+
+void SessionServer::handleLine(std::string_view line, AccountHandle & current, std::string & out, DeferredOperation & deferred)
+{
+    SessionContext session{atm, current, out, deferred.account, deferred.operation};
+    switch (sessionCommands.dispatch(session, line))
+    {
+        case DispatchResult::Handled:
+            break;
+        case DispatchResult::UnknownCommand:
+            out += "ERR unknown command\n";
+            break;
+        case DispatchResult::BadArguments:
+            out += "ERR invalid arguments\n";
+            break;
+    }
+}
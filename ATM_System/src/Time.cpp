@@ -1,17 +1,77 @@
-#include <iostream> // in/out stream
-#include <sstream> // string stream
-#include <vector> // container to save accounts && transactions
-#include <memory> // for smart pointer (shared)
-#include <string_view> // lightweight string lib
-#include <algorithm> // sorting algorithms
 #include <ctime> // get current time
-#include <iomanip> // manipulation formating of time
+#include <cstring> // memcpy
+#include "Time.hpp"
 
+namespace
+{
+    void writeDigits(char * out, int value, int width)
+    {
+        for (int i = width - 1; i >= 0; --i)
+        {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    // one cache per thread: no locking, no sharing
+    struct FormattedSecond
+    {
+        bool isFilled = false; // every epochSeconds value is a valid timestamp, so no sentinel
+        std::int64_t epochSeconds = 0;
+        char text[formattedTimeLength];
+    };
+
+    constexpr int minYear = 0;
+    constexpr int maxYear = 9'999; // the widest year 4 digits hold
+
+    thread_local FormattedSecond cachedSecond;
+}
+
+std::int64_t getEpochSeconds()
+{
+    return static_cast<std::int64_t>(std::time(nullptr)); // get current system time
+}
 
-std::string getCurrentTime()
+char * formatTime(std::int64_t epochSeconds, char * out)
 {
-    std::ostringstream oss; // format time output
-    std::time_t now = std::time(nullptr); // get current system time
-    oss << std::put_time(std::localtime(&now), "%Y-%M-%D %H:%M:%S"); // YYYY - MM - DD  HH:MM:SS
-    return oss.str();
+    if (!cachedSecond.isFilled || cachedSecond.epochSeconds != epochSeconds)
+    {
+        const auto now = static_cast<std::time_t>(epochSeconds);
+        std::tm localTime{};
+        // reentrant: std::localtime shares one static buffer across threads
+        const bool isConverted = localtime_r(&now, &localTime) != nullptr;
+
+        // years outside 0..9999 (or too far out for tm_year) clamp to the first / last representable second
+        const bool isTooEarly = isConverted ? localTime.tm_year + 1900 < minYear : epochSeconds < 0;
+        const bool isTooLate = isConverted ? localTime.tm_year + 1900 > maxYear : epochSeconds > 0;
+        if (isTooEarly || isTooLate)
+        {
+            localTime = std::tm{};
+            localTime.tm_year = (isTooEarly ? minYear : maxYear) - 1900;
+            localTime.tm_mon = isTooEarly ? 0 : 11;
+            localTime.tm_mday = isTooEarly ? 1 : 31;
+            localTime.tm_hour = isTooEarly ? 0 : 23;
+            localTime.tm_min = isTooEarly ? 0 : 59;
+            localTime.tm_sec = isTooEarly ? 0 : 59;
+        }
+
+        char * text = cachedSecond.text; // YYYY-MM-DD HH:MM:SS
+        writeDigits(text, localTime.tm_year + 1900, 4);
+        text[4] = '-';
+        writeDigits(text + 5, localTime.tm_mon + 1, 2);
+        text[7] = '-';
+        writeDigits(text + 8, localTime.tm_mday, 2);
+        text[10] = ' ';
+        writeDigits(text + 11, localTime.tm_hour, 2);
+        text[13] = ':';
+        writeDigits(text + 14, localTime.tm_min, 2);
+        text[16] = ':';
+        writeDigits(text + 17, localTime.tm_sec, 2);
+
+        cachedSecond.epochSeconds = epochSeconds;
+        cachedSecond.isFilled = true;
+    }
+
+    std::memcpy(out, cachedSecond.text, formattedTimeLength);
+    return out + formattedTimeLength;
 }
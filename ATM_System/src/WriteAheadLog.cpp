@@ -0,0 +1,622 @@
+#include <cstring> // memcpy
+#include <system_error> // open failures
+#include <vector> // replay buffer
+#include <optional> // log start record
+#include <cstdio> // rename
+#include <fcntl.h> // open
+#include <unistd.h> // write, fdatasync, ftruncate
+#include <sys/stat.h> // fstat
+#include <sys/eventfd.h> // batch notifications
+#include "WriteAheadLog.hpp"
+
+// on-disk record: [payloadSize u32][checksum u32][payload]
+// payload: [kind u8][numberLength u8][pin i32][amount i64][timeStamp i64][accountNumber]
+// settlement payload: [kind u8][legCount u16][timeStamp i64] then per leg [kind u8][numberLength u8][amount i64][accountNumber]
+// log start payload: [kind u8][baseLsn u64], only ever the first record; record lsns start at baseLsn + 1
+namespace
+{
+    constexpr std::size_t headerSize = 8;
+    constexpr std::size_t fixedPayloadSize = 1 + 1 + 4 + 8 + 8;
+    constexpr std::size_t settlementPayloadSize = 1 + 2 + 8;
+    constexpr std::size_t legSize = 1 + 1 + 8;
+    constexpr std::size_t startPayloadSize = 1 + 8;
+    constexpr std::size_t maxRecordBytes = headerSize + settlementPayloadSize + WriteAheadLog::maxSettlementLegs * (legSize + 255);
+
+    std::uint32_t checksum(const char * data, std::size_t size)
+    {
+        std::uint32_t hash = 2166136261U;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619U;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    void put(char *& out, T value)
+    {
+        std::memcpy(out, &value, sizeof(T));
+        out += sizeof(T);
+    }
+
+    template <typename T>
+    T get(const char *& in)
+    {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+
+    // legs are validated in full before any is handed out, a settlement replays all or nothing
+    bool decodeSettlement(const char * in, std::size_t payloadSize, std::uint64_t lsn, std::vector<WalRecord> & out)
+    {
+        const char * end = in + payloadSize;
+        ++in; // kind
+        const auto legCount = get<std::uint16_t>(in);
+        const auto timeStamp = get<std::int64_t>(in);
+
+        const char * legs = in;
+        for (std::size_t i = 0; i < legCount; ++i)
+        {
+            if (end - in < static_cast<std::ptrdiff_t>(legSize))
+            {
+                return false;
+            }
+            in += 1;
+            const auto numberLength = get<std::uint8_t>(in);
+            in += 8;
+            if (end - in < numberLength)
+            {
+                return false;
+            }
+            in += numberLength;
+        }
+        if (in != end)
+        {
+            return false;
+        }
+
+        in = legs;
+        for (std::size_t i = 0; i < legCount; ++i)
+        {
+            WalRecord record{};
+            record.kind = static_cast<WalRecordKind>(get<std::uint8_t>(in));
+            const auto numberLength = get<std::uint8_t>(in);
+            record.amount = Money::fromCents(get<std::int64_t>(in));
+            record.timeStamp = timeStamp;
+            record.lsn = lsn;
+            record.accountNumber = std::string_view(in, numberLength);
+            in += numberLength;
+            out.push_back(record);
+        }
+        return true;
+    }
+
+    // the base lsn if the complete record at data (size bytes) is an intact LogStart record
+    std::optional<std::uint64_t> decodeStart(const char * data, std::size_t size)
+    {
+        const auto payloadSize = get<std::uint32_t>(data);
+        const auto expectedChecksum = get<std::uint32_t>(data);
+        if (size != headerSize + startPayloadSize || payloadSize != startPayloadSize || checksum(data, payloadSize) != expectedChecksum ||
+            static_cast<WalRecordKind>(*data) != WalRecordKind::LogStart)
+        {
+            return std::nullopt;
+        }
+        ++data; // kind
+        return get<std::uint64_t>(data);
+    }
+
+    // false with errno set on a failed read, EIO when the file ends early (it was sized by fstat)
+    bool readAt(int fd, char * data, std::size_t size, std::uint64_t offset)
+    {
+        while (size > 0)
+        {
+            const ssize_t bytesRead = ::pread(fd, data, size, static_cast<off_t>(offset));
+            if (bytesRead <= 0)
+            {
+                if (bytesRead < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (bytesRead == 0)
+                {
+                    errno = EIO;
+                }
+                return false;
+            }
+            data += bytesRead;
+            size -= static_cast<std::size_t>(bytesRead);
+            offset += static_cast<std::uint64_t>(bytesRead);
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const char * data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+}
+
+WriteAheadLog::WriteAheadLog(const std::string & logPath, WalConfig walConfig) : config(walConfig), path(logPath)
+{
+    // sequence numbers continue after the last intact record, the file is cut after it;
+    // only a bad length || checksum counts as a torn tail, a file that can't be read is never cut
+    WalReader reader(path);
+    WalContents chunk;
+    std::vector<WalRecord> decoded;
+    std::size_t record = 0;
+    bool isIntact = true;
+    while (isIntact && reader.next(chunk))
+    {
+        for (record = 0; isIntact && record < chunk.size(); ++record)
+        {
+            decoded.clear();
+            isIntact = chunk.decode(record, decoded);
+        }
+    }
+    if (reader.error() != 0)
+    {
+        throw std::system_error(reader.error(), std::generic_category(), "WriteAheadLog: cannot read " + path);
+    }
+    // an intact log ends with an empty chunk at its end, otherwise the chunk stops at the bad record
+    const std::size_t intactInChunk = isIntact ? 0 : record - 1;
+    const std::uint64_t intactBytes = chunk.offsetOf(intactInChunk);
+    const std::uint64_t intactRecords = chunk.baseLsn() + intactInChunk;
+    baseLsn = reader.baseLsn();
+    startBytes = (baseLsn == 0) ? 0 : headerSize + startPayloadSize;
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644); // readable for truncate()
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "WriteAheadLog: cannot open " + path);
+    }
+    durableBytes = intactBytes;
+    appendedLsn = intactRecords;
+    durableLsn = appendedLsn;
+    if (::ftruncate(fd, static_cast<off_t>(intactBytes)) != 0)
+    {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "WriteAheadLog: cannot truncate " + path);
+    }
+    batchEventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (batchEventFd < 0)
+    {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "WriteAheadLog: eventfd");
+    }
+
+    pending.reserve(config.maxBatchBytes);
+    flusher = std::thread(&WriteAheadLog::flushLoop, this);
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    {
+        std::lock_guard lock(logMutex);
+        stopping = true;
+    }
+    flushNeeded.notify_one();
+    flusher.join();
+    ::close(batchEventFd);
+    ::close(fd);
+}
+
+std::uint64_t WriteAheadLog::append(WalRecordKind kind, std::string_view accountNumber, Money amount, std::int64_t timeStamp, std::int32_t pin)
+{
+    const std::size_t numberLength = std::min<std::size_t>(accountNumber.size(), 255);
+    const std::size_t payloadSize = fixedPayloadSize + numberLength;
+
+    std::unique_lock lock(logMutex);
+    const std::size_t offset = pending.size();
+    pending.resize(offset + headerSize + payloadSize);
+
+    char * out = pending.data() + offset + headerSize;
+    put(out, static_cast<std::uint8_t>(kind));
+    put(out, static_cast<std::uint8_t>(numberLength));
+    put(out, pin);
+    put(out, amount.getCents());
+    put(out, timeStamp);
+    std::memcpy(out, accountNumber.data(), numberLength);
+
+    return commitLocked(offset, payloadSize);
+}
+
+std::uint64_t WriteAheadLog::appendSettlement(std::span<const WalLeg> legs, std::int64_t timeStamp)
+{
+    if (legs.size() > maxSettlementLegs)
+    {
+        return 0; // a partial settlement would replay as a different transfer
+    }
+    const std::size_t legCount = legs.size();
+    std::size_t payloadSize = settlementPayloadSize;
+    for (std::size_t i = 0; i < legCount; ++i)
+    {
+        payloadSize += legSize + std::min<std::size_t>(legs[i].accountNumber.size(), 255);
+    }
+
+    std::unique_lock lock(logMutex);
+    const std::size_t offset = pending.size();
+    pending.resize(offset + headerSize + payloadSize);
+
+    char * out = pending.data() + offset + headerSize;
+    put(out, static_cast<std::uint8_t>(WalRecordKind::Settlement));
+    put(out, static_cast<std::uint16_t>(legCount));
+    put(out, timeStamp);
+    for (std::size_t i = 0; i < legCount; ++i)
+    {
+        const std::size_t numberLength = std::min<std::size_t>(legs[i].accountNumber.size(), 255);
+        put(out, static_cast<std::uint8_t>(legs[i].kind));
+        put(out, static_cast<std::uint8_t>(numberLength));
+        put(out, legs[i].amount.getCents());
+        std::memcpy(out, legs[i].accountNumber.data(), numberLength);
+        out += numberLength;
+    }
+
+    return commitLocked(offset, payloadSize);
+}
+
+std::uint64_t WriteAheadLog::commitLocked(std::size_t offset, std::size_t payloadSize)
+{
+    if (failed)
+    {
+        // the log is poisoned: nothing reaches the file again && the lsn will never be durable
+        pending.resize(offset);
+        return ++appendedLsn;
+    }
+
+    const char * payload = pending.data() + offset + headerSize;
+    char * header = pending.data() + offset;
+    put(header, static_cast<std::uint32_t>(payloadSize));
+    put(header, checksum(payload, payloadSize));
+
+    if (pendingOps++ == 0)
+    {
+        oldestPending = std::chrono::steady_clock::now();
+        flushNeeded.notify_one(); // start the latency timer
+    }
+    else if (pendingOps >= config.maxBatchOps || pending.size() >= config.maxBatchBytes)
+    {
+        flushNeeded.notify_one();
+    }
+
+    return ++appendedLsn;
+}
+
+bool WriteAheadLog::waitDurable(std::uint64_t lsn)
+{
+    std::unique_lock lock(logMutex);
+    batchDurable.wait(lock, [&] { return durableLsn >= lsn || failed; });
+    return durableLsn >= lsn; // durableLsn stops at the last good batch, so nothing after a failure succeeds
+}
+
+WalDurability WriteAheadLog::durability(std::uint64_t lsn)
+{
+    std::lock_guard lock(logMutex);
+    if (durableLsn >= lsn)
+    {
+        return WalDurability::Durable;
+    }
+    return failed ? WalDurability::Failed : WalDurability::Pending;
+}
+
+std::uint64_t WriteAheadLog::lastLsn()
+{
+    std::lock_guard lock(logMutex);
+    return appendedLsn;
+}
+
+bool WriteAheadLog::truncate(std::uint64_t coveredLsn)
+{
+    std::unique_lock lock(logMutex);
+    batchDurable.wait(lock, [&] { return !isWriting; }); // the flusher doesn't touch fd until we're done
+    if (failed || coveredLsn > durableLsn)
+    {
+        return false;
+    }
+    if (coveredLsn <= baseLsn)
+    {
+        return true; // dropped already
+    }
+
+    // the file offset of the first record after coveredLsn: walk that many record headers, a chunk at a time
+    std::vector<char> chunk(1 << 16);
+    off_t chunkStart = 0;
+    std::size_t chunkBytes = 0;
+    off_t cut = static_cast<off_t>(startBytes);
+    for (std::uint64_t record = baseLsn; record < coveredLsn; ++record)
+    {
+        if (cut < chunkStart || static_cast<std::size_t>(cut - chunkStart) + headerSize > chunkBytes)
+        {
+            const ssize_t bytesRead = ::pread(fd, chunk.data(), chunk.size(), cut);
+            if (bytesRead < static_cast<ssize_t>(headerSize))
+            {
+                return false;
+            }
+            chunkStart = cut;
+            chunkBytes = static_cast<std::size_t>(bytesRead);
+        }
+        const char * in = chunk.data() + (cut - chunkStart);
+        cut += static_cast<off_t>(headerSize + get<std::uint32_t>(in));
+    }
+
+    // opened for appending, the flusher carries on with it once it has replaced the log
+    const std::string temporaryPath = path + ".tmp";
+    const int rewritten = ::open(temporaryPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (rewritten < 0)
+    {
+        return false;
+    }
+
+    char start[headerSize + startPayloadSize];
+    char * out = start + headerSize;
+    put(out, static_cast<std::uint8_t>(WalRecordKind::LogStart));
+    put(out, coveredLsn);
+    out = start;
+    put(out, static_cast<std::uint32_t>(startPayloadSize));
+    put(out, checksum(start + headerSize, startPayloadSize));
+
+    bool isCopied = writeAll(rewritten, start, sizeof(start));
+    for (off_t offset = cut; isCopied && offset < static_cast<off_t>(durableBytes);)
+    {
+        const std::size_t wanted = std::min<std::size_t>(chunk.size(), durableBytes - static_cast<std::uint64_t>(offset));
+        const ssize_t bytesRead = ::pread(fd, chunk.data(), wanted, offset);
+        isCopied = bytesRead > 0 && writeAll(rewritten, chunk.data(), static_cast<std::size_t>(bytesRead));
+        offset += bytesRead;
+    }
+    if (!isCopied || ::fdatasync(rewritten) != 0 || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        ::close(rewritten);
+        ::unlink(temporaryPath.c_str());
+        return false;
+    }
+
+    // the rename itself must survive a crash before anything relies on the records being gone
+    const std::size_t slash = path.rfind('/');
+    const std::string directory = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    const int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directoryFd >= 0)
+    {
+        ::fsync(directoryFd);
+        ::close(directoryFd);
+    }
+
+    ::close(fd);
+    fd = rewritten;
+    durableBytes = sizeof(start) + (durableBytes - static_cast<std::uint64_t>(cut));
+    baseLsn = coveredLsn;
+    startBytes = sizeof(start);
+    return true;
+}
+
+void WriteAheadLog::flushLoop()
+{
+    std::string writing;
+    writing.reserve(config.maxBatchBytes);
+
+    std::unique_lock lock(logMutex);
+    while (true)
+    {
+        flushNeeded.wait(lock, [&] { return stopping || pendingOps > 0; });
+        if (pendingOps == 0)
+        {
+            return; // stopping && nothing left to write
+        }
+
+        // give the batch until its oldest record's deadline to fill up
+        flushNeeded.wait_until(lock, oldestPending + config.maxLatency, [&]
+        {
+            return stopping || pendingOps >= config.maxBatchOps || pending.size() >= config.maxBatchBytes;
+        });
+
+        writing.swap(pending);
+        pendingOps = 0;
+        const std::uint64_t batchLsn = appendedLsn;
+
+        isWriting = true;
+        lock.unlock();
+        const std::size_t writingBytes = writing.size();
+        const bool isWritten = writeAll(fd, writing.data(), writing.size()) && ::fdatasync(fd) == 0;
+        writing.clear();
+        lock.lock();
+        isWriting = false;
+
+        if (isWritten)
+        {
+            durableBytes += writingBytes;
+            durableLsn = batchLsn;
+        }
+        else
+        {
+            // poison the log: cut a torn batch off (best effort) so replay still reaches every durable
+            // record, then drop whatever is queued; commitLocked writes nothing from here on
+            failed = true;
+            [[maybe_unused]] const int isCut = ::ftruncate(fd, static_cast<off_t>(durableBytes));
+            pending.clear();
+            pendingOps = 0;
+        }
+        batchDurable.notify_all();
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const ssize_t isSignalled = ::write(batchEventFd, &one, sizeof(one));
+    }
+}
+
+WalReader::WalReader(const std::string & path, std::size_t chunkSize) : chunkBytes(std::max(chunkSize, headerSize))
+{
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        readError = (errno == ENOENT) ? 0 : errno; // no log yet
+        return;
+    }
+    struct stat fileInfo{};
+    if (::fstat(fd, &fileInfo) != 0)
+    {
+        readError = errno;
+        return;
+    }
+    fileSize = static_cast<std::uint64_t>(fileInfo.st_size);
+
+    // a truncated log starts with its base lsn, every later record counts on from it
+    char start[headerSize + startPayloadSize];
+    if (fileSize < sizeof(start))
+    {
+        return;
+    }
+    if (!readAt(fd, start, sizeof(start), 0))
+    {
+        readError = errno;
+        return;
+    }
+    if (const auto base = decodeStart(start, sizeof(start)))
+    {
+        startLsn = *base;
+        nextBase = *base;
+        offset = sizeof(start);
+    }
+}
+
+WalReader::~WalReader()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+}
+
+bool WalReader::next(WalContents & chunk)
+{
+    // an empty chunk at the current position unless records follow
+    chunk.offsets.assign(1, 0);
+    chunk.start = offset;
+    chunk.base = nextBase;
+    if (fd < 0 || readError != 0 || fileSize - offset < headerSize)
+    {
+        return false;
+    }
+
+    std::size_t wanted = static_cast<std::size_t>(std::min<std::uint64_t>(chunkBytes, fileSize - offset));
+    chunk.buffer.resize(wanted);
+    if (!readAt(fd, chunk.buffer.data(), wanted, offset))
+    {
+        readError = errno;
+        return false;
+    }
+    const char * in = chunk.buffer.data();
+    const std::uint64_t firstSize = headerSize + get<std::uint32_t>(in);
+    if (firstSize > fileSize - offset || firstSize > maxRecordBytes)
+    {
+        return false; // torn, or a corrupt length
+    }
+    if (firstSize > wanted)
+    {
+        // a record bigger than a chunk comes on its own
+        wanted = static_cast<std::size_t>(firstSize);
+        chunk.buffer.resize(wanted);
+        if (!readAt(fd, chunk.buffer.data(), wanted, offset))
+        {
+            readError = errno;
+            return false;
+        }
+    }
+
+    // headers only: every record that fits completely, checksums are left to decode()
+    chunk.offsets.clear();
+    std::size_t position = 0;
+    while (wanted - position >= headerSize)
+    {
+        in = chunk.buffer.data() + position;
+        const auto payloadSize = get<std::uint32_t>(in);
+        if (wanted - position - headerSize < payloadSize)
+        {
+            break;
+        }
+        chunk.offsets.push_back(position);
+        position += headerSize + payloadSize;
+    }
+    chunk.offsets.push_back(position);
+
+    offset += position;
+    nextBase += chunk.size();
+    return true;
+}
+
+bool WalContents::decode(std::size_t record, std::vector<WalRecord> & out) const
+{
+    const char * in = buffer.data() + offsets[record];
+    const auto payloadSize = get<std::uint32_t>(in);
+    const auto expectedChecksum = get<std::uint32_t>(in);
+    if (payloadSize < settlementPayloadSize || checksum(in, payloadSize) != expectedChecksum)
+    {
+        return false;
+    }
+
+    if (static_cast<WalRecordKind>(*in) == WalRecordKind::Settlement)
+    {
+        return decodeSettlement(in, payloadSize, base + record + 1, out);
+    }
+    if (payloadSize < fixedPayloadSize)
+    {
+        return false;
+    }
+
+    WalRecord decoded{};
+    decoded.kind = static_cast<WalRecordKind>(get<std::uint8_t>(in));
+    const auto numberLength = get<std::uint8_t>(in);
+    decoded.pin = get<std::int32_t>(in);
+    decoded.amount = Money::fromCents(get<std::int64_t>(in));
+    decoded.timeStamp = get<std::int64_t>(in);
+    decoded.lsn = base + record + 1;
+    if (fixedPayloadSize + numberLength != payloadSize)
+    {
+        return false;
+    }
+    decoded.accountNumber = std::string_view(in, numberLength);
+    out.push_back(decoded);
+    return true;
+}
+
+std::size_t WriteAheadLog::replay(const std::string & path, const std::function<void(const WalRecord &)> & onRecord)
+{
+    WalReader reader(path);
+    WalContents chunk;
+    std::vector<WalRecord> decoded;
+    std::size_t record = 0;
+    bool isIntact = true;
+    while (isIntact && reader.next(chunk))
+    {
+        for (record = 0; record < chunk.size(); ++record)
+        {
+            decoded.clear();
+            if (!chunk.decode(record, decoded))
+            {
+                isIntact = false; // torn or corrupt tail
+                break;
+            }
+            for (const WalRecord & walRecord : decoded)
+            {
+                onRecord(walRecord);
+            }
+        }
+    }
+
+    // an intact log ends with an empty chunk at its end
+    return static_cast<std::size_t>(chunk.offsetOf(isIntact ? 0 : record));
+}
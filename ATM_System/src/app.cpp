@@ -6,16 +6,76 @@
 #include <algorithm> // sorting algorithms
 #include <ctime> // get current time
 #include <iomanip> // manipulation formating of time
+#include <optional> // metrics export may fail
+#include <system_error> // metrics export failure
+#include <unistd.h> // getpid
 
 #include "Transactions.hpp"
 #include "Account.hpp"
 #include "ATM.hpp"
+#include "AccountSnapshot.hpp"
+#include "SessionServer.hpp"
+#include "CommandTable.hpp"
+#include "Metrics.hpp"
 
+// "<action> [amount]" -> Account operation, resolved through a compile-time perfect hash
+constexpr CommandTable<Account, 5> accountCommands({{
+    {"deposite", ArgumentKind::Amount, [](Account & account, const ParsedArguments & arguments) { account.deposite(arguments.amount); }},
+    {"withdraw", ArgumentKind::Amount, [](Account & account, const ParsedArguments & arguments) { account.withdraw(arguments.amount); }},
+    {"balance",  ArgumentKind::None,   [](Account & account, const ParsedArguments &) { account.displayBalance(); }},
+    {"history",  ArgumentKind::None,   [](Account & account, const ParsedArguments &) { account.showTransactionHistory(); }},
+    {"sort",     ArgumentKind::None,   [](Account & account, const ParsedArguments &) { account.sortTransactionsByAmount(); }},
+}});
 
-int main()
+int main(int argc, char ** argv)
 {
+    // live operation counters, read them with atm_metrics <pid> while the ATM runs;
+    // the ATM works without them, the counters just stay private
+    std::optional<MetricsExport> metrics;
+    try
+    {
+        metrics.emplace(Metrics::segmentName(::getpid()));
+    }
+    catch (const std::system_error & error)
+    {
+        std::cerr << "Metrics not exported: " << error.what() << "\n";
+    }
+
     ATM atm;
-    atm.addAccount("123", 4269, 1006.0);
+
+    // recover state from the previous run: the last checkpoint, then the journal records after it;
+    // journal everything from here on && checkpoint every minute so the journal stays short
+    const std::string snapshotPath = "atm.snap";
+    const std::string journalPath = "atm.wal";
+    const std::unique_ptr<AccountSnapshot> snapshot = AccountSnapshot::load(snapshotPath);
+    if (snapshot != nullptr)
+    {
+        atm.attachSnapshot(*snapshot);
+    }
+    if (!atm.isJournalCovered(journalPath))
+    {
+        // starting anyway would serve (&& checkpoint) balances missing everything before the journal
+        std::cerr << "Startup Failed: " << journalPath << " continues a checkpoint that " << snapshotPath << " doesn't cover!\n";
+        return 1;
+    }
+    const bool isFirstRun = (atm.replayJournal(journalPath) == 0) && (snapshot == nullptr);
+    WriteAheadLog journal(journalPath);
+    atm.attachJournal(journal);
+    const SnapshotWriter checkpoints(atm, snapshotPath, std::chrono::seconds(60));
+
+    if (isFirstRun)
+    {
+        atm.addAccount("123", 4269, Money::fromUnits(1006));
+    }
+
+    // multi-session mode: atm --serve <unix socket path>
+    if (argc == 3 && std::string_view(argv[1]) == "--serve")
+    {
+        SessionServer server(atm, argv[2]);
+        std::cout << "Serving on " << argv[2] << "\n";
+        server.run();
+        return 0;
+    }
 
     std::string accNum;
     int pinNum;
@@ -25,43 +85,31 @@ int main()
     std::cout << "Enter PIN: \n";
     std::cin >> pinNum;
 
-    auto account = atm.authenticate(accNum, pinNum);
+    const AccountHandle handle = atm.authenticate(accNum, pinNum);
+    const AccountLease account = atm.acquire(handle);
 
     if (!account)
     {
         return 0;
     }
     
-    auto performAction = [&](std::string_view action, double amount = 0)
+    auto performAction = [&](std::string_view request)
     {
-        if (action == "deposite")
-        {
-            account->deposite(amount);
-        }
-        else if (action == "withdraw")
-        {
-            account->withdraw(amount);
-        }
-        else if (action == "balance")
-        {
-            account->displayBalance();
-        }
-        else if (action == "history")
-        {
-            account->showTransactionHistory();
-        }
-        else if (action == "sort")
-        {
-            account->sortTransactionsByAmount();
-        }
-        else 
+        switch (accountCommands.dispatch(*account, request))
         {
-            std::cout << "Invalid Action!\n";
+            case DispatchResult::Handled:
+                break;
+            case DispatchResult::UnknownCommand:
+                std::cout << "Invalid Action!\n";
+                break;
+            case DispatchResult::BadArguments:
+                std::cout << "Invalid Arguments!\n";
+                break;
         }
     };
 
-    performAction("deposite", 500);
-    performAction("withdraw", 500);
+    performAction("deposite 500");
+    performAction("withdraw 500");
     performAction("balance");
     performAction("history");
 
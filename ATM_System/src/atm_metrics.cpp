@@ -0,0 +1,51 @@
+// scraper for a running ATM: maps its metrics segment read-only && prints the merged counters
+// usage: atm_metrics <pid of the ATM | /segment name> [intervalMs=0 (print once)]
+#include <cstdio> // printf
+#include <cstdlib> // strtoul, strtol
+#include <string> // segment name
+#include <thread> // sleep between scrapes
+#include <chrono> // interval
+#include "Metrics.hpp"
+
+int main(int argc, char ** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <pid | /segment> [intervalMs]\n", argv[0]);
+        return 1;
+    }
+    const std::string name = (argv[1][0] == '/') ? std::string(argv[1]) : Metrics::segmentName(std::strtol(argv[1], nullptr, 10));
+    const unsigned long intervalMs = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+    const auto reader = MetricsReader::open(name);
+    if (reader == nullptr)
+    {
+        std::fprintf(stderr, "no ATM metrics published as %s\n", name.c_str());
+        return 1;
+    }
+
+    do
+    {
+        std::printf("%-14s %12s %10s %10s %10s %10s %10s\n", "operation", "count", "failures", "mean ns", "p50 ns", "p99 ns", "p999 ns");
+        for (std::size_t i = 0; i < metricOpCount; ++i)
+        {
+            const auto op = static_cast<MetricOp>(i);
+            const OperationSummary summary = reader->summarize(op);
+            const double ticksPerNanosecond = reader->ticksPerNanosecond();
+            std::printf("%-14.*s %12llu %10llu %10.0f %10.0f %10.0f %10.0f\n",
+                        static_cast<int>(toString(op).size()), toString(op).data(),
+                        static_cast<unsigned long long>(summary.count), static_cast<unsigned long long>(summary.failures),
+                        summary.meanNanoseconds, summary.percentileNanoseconds(0.50, ticksPerNanosecond),
+                        summary.percentileNanoseconds(0.99, ticksPerNanosecond), summary.percentileNanoseconds(0.999, ticksPerNanosecond));
+        }
+        std::fflush(stdout);
+
+        if (intervalMs != 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+            std::printf("\n");
+        }
+    } while (intervalMs != 0);
+
+    return 0;
+}
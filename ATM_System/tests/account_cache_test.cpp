@@ -0,0 +1,141 @@
+// AccountCache over a journal: changes made through leases survive a crash that loses the cache
+// (nothing flushed), recover() puts them back into the store exactly once; && concurrent leases on
+// a cache much smaller than the population neither lose nor duplicate deposits
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <unistd.h>
+
+#include "AccountCache.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    std::int64_t storedCents(AccountStore & store, const std::string & accountNumber)
+    {
+        const std::unique_ptr<Account> account = store.load(accountNumber);
+        return (account == nullptr) ? -1 : account->getBalance().getCents();
+    }
+}
+
+int main()
+{
+    const std::string storePath = "/tmp/atm_account_cache_test_" + std::to_string(::getpid()) + ".store";
+    const std::string journalPath = "/tmp/atm_account_cache_test_" + std::to_string(::getpid()) + ".wal";
+    ::unlink(storePath.c_str());
+    ::unlink(journalPath.c_str());
+
+    const std::vector<std::string> numbers = {"6001", "6002", "6003", "6004"};
+    std::vector<std::int64_t> expectedCents(numbers.size(), 10'000);
+    {
+        AccountStore store(storePath);
+        WriteAheadLog journal(journalPath, WalConfig{1, 1 << 20, std::chrono::microseconds(1)});
+        // the cache dies with the process: never destroyed, so nothing is flushed
+        AccountCache * cache = new AccountCache(store, 2, &journal);
+        for (const std::string & number : numbers)
+        {
+            check(cache->addAccount(number, 1234, Money::fromUnits(100)), "addAccount");
+        }
+        check(!cache->addAccount(numbers[0], 1234, Money::fromUnits(100)), "adding an account twice");
+
+        // two entries for four accounts: some changes get written back on eviction, the last ones don't
+        for (int round = 0; round < 5; ++round)
+        {
+            for (std::size_t i = 0; i < numbers.size(); ++i)
+            {
+                const Operation batch[] = {{TransactionType::Deposit, Money::fromCents(700)}, {TransactionType::Withdrawal, Money::fromCents(200 + static_cast<std::int64_t>(i))}};
+                AccountLease lease = cache->acquire(numbers[i], AccessMode::Write);
+                check(static_cast<bool>(lease), "acquire");
+                const std::vector<OperationResult> results = lease->applyBatch(batch);
+                check(results[0] == OperationResult::Applied && results[1] == OperationResult::Applied, "journaled batch");
+                expectedCents[i] += 500 - static_cast<std::int64_t>(i);
+            }
+        }
+        check(!cache->acquire("6999", AccessMode::Read), "an unknown account was found");
+    }
+
+    {
+        AccountStore store(storePath);
+        bool isBehind = false;
+        for (std::size_t i = 0; i < numbers.size(); ++i)
+        {
+            isBehind = isBehind || storedCents(store, numbers[i]) != expectedCents[i];
+        }
+        check(isBehind, "the store was up to date without recovery");
+
+        AccountCache cache(store, 2);
+        check(cache.recover(journalPath) > 0, "recover applied nothing");
+        for (std::size_t i = 0; i < numbers.size(); ++i)
+        {
+            check(storedCents(store, numbers[i]) == expectedCents[i], "recovered balance");
+            const AccountLease lease = cache.acquire(numbers[i], AccessMode::Read);
+            check(lease && lease->snapshot().size() == 10, "recovered history");
+        }
+        check(cache.recover(journalPath) == 0, "a second recovery applied records again");
+    }
+
+    // concurrent leases: 4 threads, 16 accounts, 6 entries
+    ::unlink(storePath.c_str());
+    {
+        AccountStore store(storePath);
+        std::vector<std::string> shared;
+        for (int id = 0; id < 16; ++id)
+        {
+            shared.push_back(std::to_string(7000 + id));
+            store.add(Account(shared.back(), 1234, Money{}));
+        }
+        {
+            AccountCache cache(store, 6);
+            std::atomic<unsigned> unavailable{0};
+            std::vector<std::thread> workers;
+            for (unsigned worker = 0; worker < 4; ++worker)
+            {
+                workers.emplace_back([&, worker]
+                {
+                    const Operation deposit{TransactionType::Deposit, Money::fromCents(1)};
+                    for (unsigned i = 0; i < 2'000; ++i)
+                    {
+                        const AccountLease lease = cache.acquire(shared[(i * 7 + worker) % shared.size()], AccessMode::Write);
+                        if (lease)
+                        {
+                            lease->applyBatch(std::span<const Operation>(&deposit, 1));
+                        }
+                        else
+                        {
+                            unavailable.fetch_add(1);
+                        }
+                    }
+                });
+            }
+            for (std::thread & worker : workers)
+            {
+                worker.join();
+            }
+            check(unavailable.load() == 0, "no entry with fewer leases than entries");
+            check(cache.flush(), "flush");
+        }
+        std::int64_t totalCents = 0;
+        for (const std::string & number : shared)
+        {
+            totalCents += storedCents(store, number);
+        }
+        check(totalCents == 4 * 2'000, "concurrent deposits lost or duplicated");
+    }
+
+    ::unlink(storePath.c_str());
+    ::unlink(journalPath.c_str());
+    std::printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
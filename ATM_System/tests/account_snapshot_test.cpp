@@ -0,0 +1,164 @@
+// a damaged snapshot is never followed out of the mapping: AccountSnapshot::load rejects counts that
+// overflow the file, && the lookups reject what load no longer scans (it only reads the header):
+// account records with bad lengths || transaction ranges, index entries past the table, an index
+// without a free slot && unknown transaction types; an ATM serving such a file refuses the damaged
+// account, keeps serving the rest && won't write a snapshot missing it;
+// a materialized account's history is read from the mapping on its first use;
+// && ATM never accepts an account a snapshot can't hold
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <unistd.h>
+
+#include "ATM.hpp"
+#include "AccountSnapshot.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    std::string readFile(const std::string & path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string & path, const std::string & bytes)
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+    }
+
+    template <typename Field>
+    void patch(std::string & bytes, std::size_t offset, Field value)
+    {
+        std::memcpy(bytes.data() + offset, &value, sizeof(value));
+    }
+}
+
+int main()
+{
+    const std::string path = "/tmp/atm_account_snapshot_test_" + std::to_string(::getpid()) + ".snap";
+    {
+        ATM atm;
+        for (int id = 0; id < 5; ++id)
+        {
+            atm.addAccount(std::to_string(8000 + id), 1234, Money::fromUnits(100));
+            const Operation deposit{TransactionType::Deposit, Money::fromCents(250)};
+            atm.acquire(atm.authenticate(std::to_string(8000 + id), 1234))->applyBatch(std::span<const Operation>(&deposit, 1));
+        }
+        check(!atm.addAccount(std::string(ATM::maxAccountNumberLength + 1, '9'), 1234, Money{}), "an account number too long for a snapshot was accepted");
+        check(atm.addAccount(std::string(ATM::maxAccountNumberLength, '9'), 1234, Money{}), "the longest account number was refused");
+        check(AccountSnapshot::write(path, atm), "write");
+    }
+    const std::string original = readFile(path);
+    {
+        const auto snapshot = AccountSnapshot::load(path);
+        check(snapshot != nullptr && snapshot->size() == 6, "an intact snapshot was rejected");
+        check(snapshot && snapshot->find("8003") != nullptr && snapshot->amountColumn(*snapshot->find("8003")).size() == 1, "lookup");
+
+        // a materialized account reads its history from the mapping on first use, through every accessor
+        ATM atm;
+        atm.attachSnapshot(*snapshot);
+        const AccountLease statsFirst = atm.acquire(atm.tryAuthenticate("8001", 1234), AccessMode::Read);
+        check(statsFirst && statsFirst->getTotal(TransactionType::Deposit) == Money::fromCents(250) &&
+              statsFirst->snapshot().size() == 1, "history of a materialized account, totals first");
+        const AccountLease historyFirst = atm.acquire(atm.tryAuthenticate("8002", 1234), AccessMode::Read);
+        check(historyFirst && historyFirst->snapshot().size() == 1 && historyFirst->snapshot().getBalance() == Money::fromCents(10'250) &&
+              historyFirst->getBalance() == Money::fromCents(10'250), "history of a materialized account, lock-free snapshot first");
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(&header, original.data(), sizeof(header));
+    const std::size_t firstAccount = sizeof(SnapshotHeader);
+    const std::size_t firstIndexSlot = firstAccount + header.accountCount * sizeof(SnapshotAccount);
+    const std::size_t firstType = firstIndexSlot + header.indexCapacity * sizeof(std::uint64_t) + 2 * header.transactionCount * sizeof(std::int64_t);
+
+    const auto isRejected = [&](const std::function<void (std::string &)> & damage)
+    {
+        std::string bytes = original;
+        damage(bytes);
+        writeFile(path, bytes);
+        return AccountSnapshot::load(path) == nullptr;
+    };
+
+    check(isRejected([&](std::string & bytes) { patch(bytes, offsetof(SnapshotHeader, accountCount), ~std::uint64_t{0} / 2); }), "overflowing account count");
+    check(isRejected([&](std::string & bytes) { patch(bytes, offsetof(SnapshotHeader, transactionCount), header.transactionCount + 1); }), "transaction count past the file");
+    check(isRejected([&](std::string & bytes) { patch(bytes, offsetof(SnapshotHeader, indexCapacity), header.indexCapacity - 1); }), "index capacity not a power of two");
+    check(!isRejected([](std::string &) {}), "rewritten intact snapshot was rejected");
+
+    // record damage loads: the first account record (its transactions come first in the columns) is refused
+    // where it is used, every other account still works
+    SnapshotAccount damaged{};
+    std::memcpy(&damaged, original.data() + firstAccount, sizeof(damaged));
+    const std::string damagedNumber(damaged.getAccountNumber());
+    const std::string intactNumber = (damagedNumber == "8000") ? "8001" : "8000";
+    const auto isRejectedOnUse = [&](const std::function<void (std::string &)> & damage, bool isIndexDamaged)
+    {
+        std::string bytes = original;
+        damage(bytes);
+        writeFile(path, bytes);
+        const auto snapshot = AccountSnapshot::load(path);
+        if (snapshot == nullptr)
+        {
+            return false;
+        }
+        const bool isLookupRejected = snapshot->find(damagedNumber) == nullptr && snapshot->find("no such account") == nullptr;
+        if (isIndexDamaged)
+        {
+            return isLookupRejected;
+        }
+
+        ATM atm;
+        atm.attachSnapshot(*snapshot);
+        const bool isServed = atm.tryAuthenticate(intactNumber, 1234) && !atm.tryAuthenticate(damagedNumber, 1234);
+        const bool isNumberKept = !atm.addAccount(damagedNumber, 1234, Money{});
+        const bool isWriteRefused = !atm.forEachAccount([](auto &&...) {}) && !AccountSnapshot::write(path + ".copy", atm);
+        return isLookupRejected && snapshot->at(0) == nullptr && isServed && isNumberKept && isWriteRefused;
+    };
+
+    check(isRejectedOnUse([&](std::string & bytes) { patch(bytes, firstAccount + offsetof(SnapshotAccount, firstTransaction), header.transactionCount); }, false), "transactions past the columns");
+    check(isRejectedOnUse([&](std::string & bytes) { patch(bytes, firstAccount + offsetof(SnapshotAccount, transactionCount), ~std::uint64_t{0}); }, false), "overflowing transaction range");
+    check(isRejectedOnUse([&](std::string & bytes) { bytes[firstType] = 9; }, false), "unknown transaction type");
+    check(isRejectedOnUse([&](std::string & bytes)
+    {
+        for (std::uint64_t slot = 0; slot < header.indexCapacity; ++slot)
+        {
+            patch(bytes, firstIndexSlot + slot * sizeof(std::uint64_t), header.accountCount + 1);
+        }
+    }, true), "index entries past the table");
+    check(isRejectedOnUse([&](std::string & bytes)
+    {
+        // every slot points at the last account: probes must stop after one lap
+        for (std::uint64_t slot = 0; slot < header.indexCapacity; ++slot)
+        {
+            patch(bytes, firstIndexSlot + slot * sizeof(std::uint64_t), header.accountCount);
+        }
+    }, true), "index without a free slot");
+    {
+        // a damaged length is never used to read past the field, the number just stops matching
+        std::string bytes = original;
+        patch(bytes, firstAccount + offsetof(SnapshotAccount, numberLength), std::uint8_t{200});
+        writeFile(path, bytes);
+        const auto snapshot = AccountSnapshot::load(path);
+        check(snapshot != nullptr && snapshot->find(damagedNumber) == nullptr && snapshot->at(0) == nullptr &&
+              snapshot->accountNumberAt(0).empty() && snapshot->find(intactNumber) != nullptr, "number longer than its field");
+    }
+    ::unlink((path + ".copy").c_str());
+
+    ::unlink(path.c_str());
+    std::printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
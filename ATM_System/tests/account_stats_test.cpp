@@ -0,0 +1,84 @@
+// withdrawal day && calendar month totals: boundaries, a first withdrawal (no period yet) && a
+// query far from any recorded period, which used to subtract from the INT64_MIN sentinel
+// the periods are UTC calendar ones: days turn over at 00:00 UTC, months on the 1st at 00:00 UTC
+// outgoing transfers count like withdrawals, sums saturate instead of overflowing,
+// && a transfer over the daily limit is refused like a withdrawal over it
+#include <cstdio>
+#include <limits>
+
+#include "AccountStats.hpp"
+#include "ATM.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    constexpr std::size_t deposit = 0;
+    constexpr std::size_t withdrawal = 1;
+    constexpr std::size_t transferOut = 2;
+    constexpr std::int64_t day = 86'400;
+    constexpr std::int64_t januaryThirtyFirst = 1'706'659'200; // 2024-01-31 00:00:00 UTC
+}
+
+int main()
+{
+    AccountStats<3> stats({withdrawal, transferOut});
+    check(stats.withdrawnOnDayOf(januaryThirtyFirst) == 0 && stats.withdrawnInMonthOf(januaryThirtyFirst) == 0, "fresh stats report withdrawals");
+    check(stats.withdrawnInMonthOf(std::numeric_limits<std::int64_t>::max() / 2) == 0, "a far future query reports withdrawals");
+
+    stats.record(withdrawal, 1'000, januaryThirtyFirst + 100);
+    stats.record(deposit, 5'000, januaryThirtyFirst + 200);
+    stats.record(withdrawal, 2'000, januaryThirtyFirst + day - 1);
+    check(stats.withdrawnOnDayOf(januaryThirtyFirst + 10) == 3'000, "same day total");
+    check(stats.withdrawnInMonthOf(januaryThirtyFirst) == 3'000, "same month total");
+    check(stats.withdrawnOnDayOf(januaryThirtyFirst + day) == 0, "the day total carried over midnight");
+    check(stats.withdrawnInMonthOf(januaryThirtyFirst + day) == 0, "the month total carried into February");
+    check(stats.withdrawnInMonthOf(januaryThirtyFirst - 30 * day) == 3'000, "January 1st is not in the same month");
+
+    stats.record(withdrawal, 4'000, januaryThirtyFirst + day + 5); // February 1st
+    check(stats.withdrawnOnDayOf(januaryThirtyFirst + day) == 4'000, "new day total");
+    check(stats.withdrawnInMonthOf(januaryThirtyFirst + 29 * day) == 4'000, "February 29th is in the same month");
+    check(stats.withdrawnInMonthOf(januaryThirtyFirst + 30 * day) == 0, "March 1st is not in February");
+
+    stats.record(withdrawal, 500, januaryThirtyFirst + 2 * day);
+    check(stats.withdrawnOnDayOf(januaryThirtyFirst + 2 * day) == 500 && stats.withdrawnInMonthOf(januaryThirtyFirst + 2 * day) == 4'500, "second day in the month");
+    check(stats.getTotals(withdrawal).sumCents == 7'500 && stats.getTotals(deposit).count == 1, "per type totals");
+
+    stats.record(transferOut, 250, januaryThirtyFirst + 2 * day + 1);
+    check(stats.withdrawnOnDayOf(januaryThirtyFirst + 2 * day) == 750 && stats.withdrawnInMonthOf(januaryThirtyFirst + 2 * day) == 4'750, "outgoing transfer not counted");
+
+    constexpr std::int64_t maxCents = std::numeric_limits<std::int64_t>::max();
+    stats.record(deposit, maxCents, januaryThirtyFirst + 3 * day);
+    stats.record(withdrawal, maxCents, januaryThirtyFirst + 3 * day);
+    check(stats.getTotals(deposit).sumCents == maxCents && stats.getTotals(withdrawal).sumCents == maxCents, "per type sum wrapped");
+    check(stats.withdrawnOnDayOf(januaryThirtyFirst + 3 * day) == maxCents && stats.withdrawnInMonthOf(januaryThirtyFirst + 3 * day) == maxCents, "day && month sums wrapped");
+
+    {
+        ATM atm;
+        atm.addAccount("1", 1111, Money::fromUnits(1'000));
+        atm.addAccount("2", 2222, Money{});
+        const AccountHandle from = atm.tryAuthenticate("1", 1111);
+        const AccountHandle to = atm.tryAuthenticate("2", 2222);
+        atm.acquire(from)->setWithdrawalLimits(WithdrawalLimits{Money::fromUnits(100), WithdrawalLimits::unlimited});
+        check(atm.transfer(from, to, Money::fromUnits(60)) == OperationResult::Applied, "transfer within the limit");
+        check(atm.transfer(from, to, Money::fromUnits(60)) == OperationResult::LimitExceeded, "transfer over the daily limit");
+        check(!atm.acquire(from)->withdraw(Money::fromUnits(41)), "withdrawal over what the transfer left of the limit");
+        const Transfer batch[] = {{from, to, Money::fromUnits(30)}, {to, from, Money::fromUnits(5)}};
+        const std::vector<OperationResult> results = atm.settle(batch);
+        check(results[0] == OperationResult::Applied && results[1] == OperationResult::Applied, "netted settlement within the limit");
+        check(atm.acquire(from)->withdrawnToday() == Money::fromUnits(85), "settlement debit counted net");
+        check(atm.acquire(from)->getBalance() == Money::fromUnits(915), "balance after the transfers");
+    }
+
+    std::printf("account stats (%zu bytes): %s\n", sizeof(stats), failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// AccountStore round trips: everything an account carries (PIN, balance, history, withdrawal limits)
+// comes back from the file, also after the store is reopened && after a record has moved slots;
+// a damaged record is skipped: an older intact copy of the account is used, later records still load
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <unistd.h>
+
+#include "AccountStore.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    std::string readFile(const std::string & path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string & path, const std::string & bytes)
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+    }
+
+    // start of every record holding accountNumber (the number follows the fixed record header)
+    std::vector<std::size_t> recordsOf(const std::string & bytes, const std::string & accountNumber)
+    {
+        std::vector<std::size_t> offsets;
+        for (std::size_t found = bytes.find(accountNumber); found != std::string::npos; found = bytes.find(accountNumber, found + 1))
+        {
+            offsets.push_back(found - sizeof(StoreRecord));
+        }
+        return offsets;
+    }
+}
+
+int main()
+{
+    const std::string path = "/tmp/atm_account_store_test_" + std::to_string(::getpid()) + ".store";
+    ::unlink(path.c_str());
+
+    const WithdrawalLimits limits{Money::fromUnits(300), Money::fromUnits(2'000)};
+    {
+        AccountStore store(path);
+        Account account("5001", 4321, Money::fromUnits(50));
+        check(store.add(account), "add");
+        check(!store.add(account), "adding the same account twice");
+
+        account.setWithdrawalLimits(limits);
+        for (int i = 0; i < 40; ++i)
+        {
+            account.restore(TransactionType::Deposit, Money::fromCents(100 + i), 1'700'000'000 + i); // outgrows its first slot
+        }
+        check(store.save(account), "save");
+        check(store.wastedBytes() > 0, "a grown record moves to a new slot");
+        check(store.sync(), "sync");
+    }
+
+    AccountStore reopened(path);
+    check(reopened.size() == 1 && reopened.contains("5001"), "reopened index");
+    const std::unique_ptr<Account> loaded = reopened.load("5001");
+    check(loaded != nullptr, "load");
+    if (loaded != nullptr)
+    {
+        const WithdrawalLimits loadedLimits = loaded->getWithdrawalLimits();
+        check(loaded->authenticate(4321), "PIN");
+        check(loaded->getBalance() == Money::fromCents(5'000 + 40 * 100 + 780), "balance");
+        check(loaded->snapshot().size() == 40 && loaded->snapshot()[39].amount == Money::fromCents(139), "history");
+        check(loadedLimits.daily == limits.daily && loadedLimits.monthly == limits.monthly, "withdrawal limits");
+    }
+    check(reopened.load("5002") == nullptr, "unknown account");
+    ::unlink(path.c_str());
+
+    // three accounts, the middle one saved twice: its first copy stays on disk until its slot is reused
+    {
+        AccountStore store(path);
+        for (const char * number : {"6001", "6002", "6003"})
+        {
+            store.add(Account(number, 1111, Money::fromUnits(10)));
+        }
+        Account changed("6002", 1111, Money::fromUnits(10));
+        changed.restore(TransactionType::Deposit, Money::fromUnits(5), 1'700'000'000);
+        store.save(changed);
+        store.sync();
+    }
+    std::string bytes = readFile(path);
+    const std::vector<std::size_t> copies = recordsOf(bytes, "6002");
+    check(copies.size() == 2 && copies[0] < copies[1], "a save leaves the previous copy intact");
+    if (copies.size() == 2)
+    {
+        bytes[copies[1] + sizeof(StoreRecord) + 4 + 2] ^= 0x5A; // inside the newer copy's history
+    }
+    writeFile(path, bytes);
+    {
+        AccountStore store(path);
+        const std::unique_ptr<Account> older = store.load("6002");
+        check(older != nullptr && older->getBalance() == Money::fromUnits(10), "a damaged record falls back to the previous copy");
+        check(store.load("6003") != nullptr, "records after a damaged one are still found");
+    }
+
+    // a garbage slot header: the scan can't size the slot, it steps over it && finds the next one
+    bytes = readFile(path);
+    const std::vector<std::size_t> first = recordsOf(bytes, "6001");
+    if (!first.empty())
+    {
+        bytes.replace(first[0], sizeof(std::uint32_t), std::string(sizeof(std::uint32_t), '\xFF'));
+    }
+    writeFile(path, bytes);
+    {
+        AccountStore store(path);
+        check(!store.contains("6001"), "a record with a garbage header is dropped");
+        check(store.contains("6002") && store.contains("6003"), "the scan stopped at a garbage header");
+    }
+
+    ::unlink(path.c_str());
+    std::printf("account store: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
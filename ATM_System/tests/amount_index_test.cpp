@@ -0,0 +1,107 @@
+// amount queries over a lazily built index: largest, amount ranges && the full sort agree with a brute
+// force over the log while rows keep arriving between queries, after a truncation && after a freeze/thaw
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstdio>
+
+#include "Transactions.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    bool isSame(const std::vector<Transaction> & left, const std::vector<Transaction> & right)
+    {
+        return std::equal(left.begin(), left.end(), right.begin(), right.end(), [](const Transaction & a, const Transaction & b)
+        {
+            return a.type == b.type && a.amount == b.amount && a.timeStamp == b.timeStamp;
+        });
+    }
+
+    // brute force: (amount, position) order, the index's order
+    std::vector<Transaction> expectedSorted(const TransactionLog & log, bool isTypeFiltered, TransactionType type)
+    {
+        std::vector<std::size_t> positions;
+        for (std::size_t i = 0; i < log.size(); ++i)
+        {
+            if (!isTypeFiltered || log[i].type == type)
+            {
+                positions.push_back(i);
+            }
+        }
+        std::stable_sort(positions.begin(), positions.end(), [&](std::size_t left, std::size_t right) { return log[left].amount < log[right].amount; });
+        std::vector<Transaction> rows;
+        for (const std::size_t position : positions)
+        {
+            rows.push_back(log[position]);
+        }
+        return rows;
+    }
+
+    void checkQueries(const TransactionLog & log, const char * what)
+    {
+        check(isSame(log.sortedByAmount(), expectedSorted(log, false, TransactionType::Deposit)), what);
+        for (const TransactionType type : {TransactionType::Deposit, TransactionType::Withdrawal})
+        {
+            const std::vector<Transaction> sorted = expectedSorted(log, true, type);
+            const std::vector<Transaction> largest(sorted.rbegin(), sorted.rbegin() + static_cast<std::ptrdiff_t>(std::min<std::size_t>(5, sorted.size())));
+            check(isSame(log.largest(type, 5), largest), what);
+
+            std::vector<Transaction> inRange;
+            std::copy_if(sorted.begin(), sorted.end(), std::back_inserter(inRange), [](const Transaction & row)
+            {
+                return row.amount >= Money::fromCents(200) && row.amount <= Money::fromCents(600);
+            });
+            check(isSame(log.inAmountRange(type, Money::fromCents(200), Money::fromCents(600)), inRange), what);
+        }
+    }
+}
+
+int main()
+{
+    TransactionLog log;
+    std::uint64_t state = 12345;
+    const auto next = [&state]
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+    const auto appendRows = [&](int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            // few distinct amounts, so ties have to keep chronological order
+            log.append((next() % 2 == 0) ? TransactionType::Deposit : TransactionType::Withdrawal, Money::fromCents(static_cast<std::int64_t>(next() % 40) * 25), 1'700'000'000 + i);
+        }
+    };
+
+    check(log.sortedByAmount().empty() && log.largest(TransactionType::Deposit, 3).empty(), "queries on an empty log");
+    appendRows(100);
+    checkQueries(log, "first query");
+    appendRows(37);
+    checkQueries(log, "rows appended after the first query");
+    appendRows(1);
+    checkQueries(log, "one row appended");
+
+    log.truncate(90);
+    checkQueries(log, "after a truncation");
+    appendRows(50);
+    checkQueries(log, "rows appended after a truncation");
+
+    check(log.freeze(), "freeze");
+    log.thaw();
+    checkQueries(log, "after a freeze && thaw");
+
+    std::printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
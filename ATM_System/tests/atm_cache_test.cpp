@@ -0,0 +1,169 @@
+// an ATM built on a store with far more accounts than it keeps resident: accounts fault in && get evicted
+// while authenticate, deposits, transfers && a settlement bigger than the cache run, handles keep working
+// across evictions, && the same accounts come back from the flushed store, from a journal replayed into
+// an empty store (the cache that small) && from a snapshot of the store-backed ATM
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+
+#include "ATM.hpp"
+#include "AccountSnapshot.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    struct AccountState
+    {
+        int pin;
+        std::int64_t balanceCents;
+        std::vector<std::int64_t> amounts;
+
+        bool operator==(const AccountState &) const = default;
+    };
+
+    std::map<std::string, AccountState> capture(const ATM & atm)
+    {
+        std::map<std::string, AccountState> state;
+        const bool isComplete = atm.forEachAccount([&](std::string_view accountNumber, int pin, Money balance, std::span<const TransactionType>,
+                                                       std::span<const std::int64_t> amountColumn, std::span<const std::int64_t>, std::uint64_t)
+        {
+            state.emplace(std::string(accountNumber), AccountState{pin, balance.getCents(), {amountColumn.begin(), amountColumn.end()}});
+        });
+        check(isComplete, "forEachAccount skipped an account");
+        return state;
+    }
+
+    std::string number(int id)
+    {
+        return std::to_string(7000 + id);
+    }
+}
+
+int main()
+{
+    const std::string base = "/tmp/atm_cache_test_" + std::to_string(::getpid());
+    const std::string storePath = base + ".store";
+    const std::string journalPath = base + ".wal";
+    const std::string replayedPath = base + "_replayed.store";
+    const std::string snapshotPath = base + ".snap";
+    const std::string restoredPath = base + "_restored.store";
+    for (const std::string & path : {storePath, journalPath, replayedPath, snapshotPath, restoredPath})
+    {
+        ::unlink(path.c_str());
+    }
+
+    constexpr int accountCount = 64;
+    constexpr std::size_t residentAccounts = 8;
+    std::map<std::string, AccountState> expected;
+    {
+        AccountStore store(storePath);
+        WriteAheadLog journal(journalPath, WalConfig{1, 1 << 20, std::chrono::microseconds(1)});
+        ATM atm(store, residentAccounts);
+        atm.attachJournal(journal);
+        for (int id = 0; id < accountCount; ++id)
+        {
+            check(atm.addAccount(number(id), 1234, Money::fromUnits(100)), "addAccount");
+        }
+        check(!atm.addAccount(number(0), 1234, Money::fromUnits(100)), "adding an account twice");
+
+        // held across every eviction below: it names the account, not where it is resident
+        const AccountHandle first = atm.tryAuthenticate(number(0), 1234);
+        check(static_cast<bool>(first), "authenticate");
+        check(!atm.tryAuthenticate(number(1), 4321), "wrong PIN accepted");
+        check(!atm.tryAuthenticate("6999", 1234), "unknown account accepted");
+
+        for (int round = 0; round < 3; ++round)
+        {
+            for (int id = 0; id < accountCount; ++id)
+            {
+                const Operation batch[] = {{TransactionType::Deposit, Money::fromCents(500 + id)}, {TransactionType::Withdrawal, Money::fromCents(100)}};
+                AccountLease account = atm.acquire(atm.tryAuthenticate(number(id), 1234));
+                check(account && account->applyBatch(batch)[1] == OperationResult::Applied, "operations on a faulted-in account");
+            }
+            for (int id = 0; id < accountCount; ++id)
+            {
+                const OperationResult result = atm.transfer(atm.tryAuthenticate(number(id), 1234), atm.tryAuthenticate(number((id * 7 + 3) % accountCount), 1234), Money::fromCents(id + 1));
+                check(result == OperationResult::Applied, "transfer between accounts that aren't both resident");
+            }
+        }
+
+        // five times as many accounts as fit: applied one transfer at a time
+        std::vector<Transfer> transfers;
+        for (int id = 0; id < 40; ++id)
+        {
+            transfers.push_back(Transfer{atm.tryAuthenticate(number(id), 1234), atm.tryAuthenticate(number(id + 1), 1234), Money::fromCents(10)});
+        }
+        for (const OperationResult result : atm.settle(transfers))
+        {
+            check(result == OperationResult::Applied, "settlement over more accounts than the cache holds");
+        }
+        check(atm.transfer(first, first, Money::fromCents(1)) == OperationResult::InvalidAccount, "transfer to itself");
+
+        const AccountLease firstAccount = atm.acquire(first, AccessMode::Read);
+        check(firstAccount && firstAccount->getAccountNumber() == number(0), "handle resolved after its account was evicted");
+
+        const CacheStats stats = atm.cacheStats();
+        check(stats.evictions > 0 && stats.writeBacks > 0, "nothing was evicted");
+        check(stats.resident <= residentAccounts && stats.capacity == residentAccounts, "more accounts resident than the capacity");
+        check(stats.hits > 0 && stats.misses > 0, "hit && miss counters");
+
+        expected = capture(atm);
+        check(expected.size() == accountCount, "forEachAccount over resident && evicted accounts");
+        std::int64_t totalCents = 0;
+        for (const auto & [accountNumber, state] : expected)
+        {
+            totalCents += state.balanceCents;
+        }
+        check(totalCents == accountCount * (10'000 + 3 * 400) + 3 * (accountCount * (accountCount - 1) / 2), "transfers created || lost money");
+
+        check(AccountSnapshot::write(snapshotPath, atm), "snapshot of a store-backed ATM");
+    }
+
+    {
+        // reopened: everything was written back when the ATM went away
+        AccountStore store(storePath);
+        ATM atm(store, residentAccounts);
+        check(capture(atm) == expected, "flushed store");
+        check(static_cast<bool>(atm.tryAuthenticate(number(accountCount - 1), 1234)), "authenticate from a reopened store");
+    }
+
+    {
+        AccountStore store(replayedPath);
+        ATM atm(store, 4);
+        check(atm.replayJournal(journalPath) > 0, "replay into an empty store");
+        check(capture(atm) == expected, "journal replayed through a small cache");
+        check(atm.cacheStats().evictions > 0, "the replay fit in the cache");
+    }
+
+    {
+        const std::unique_ptr<AccountSnapshot> snapshot = AccountSnapshot::load(snapshotPath);
+        check(snapshot != nullptr, "snapshot load");
+        AccountStore store(restoredPath);
+        ATM atm(store, residentAccounts);
+        atm.attachSnapshot(*snapshot);
+        check(capture(atm) == expected, "snapshot accounts not yet stored");
+        const AccountLease account = atm.acquire(atm.tryAuthenticate(number(5), 1234), AccessMode::Read);
+        check(account && account->getBalance().getCents() == expected[number(5)].balanceCents, "account faulted in from the snapshot");
+        check(store.contains(number(5)) && store.size() == 1, "only the used account was copied into the store");
+        check(capture(atm) == expected, "snapshot && store accounts together");
+    }
+
+    for (const std::string & path : {storePath, journalPath, replayedPath, snapshotPath, restoredPath})
+    {
+        ::unlink(path.c_str());
+    }
+    std::printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
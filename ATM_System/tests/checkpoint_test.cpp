@@ -0,0 +1,171 @@
+// snapshot + journal checkpoints: a checkpoint drops the journal records the snapshot covers, a restart
+// (snapshot, then the rest of the journal) rebuilds exactly the same accounts, sequence numbers carry on
+// across the truncation, replaying records a snapshot already includes changes nothing,
+// && exporting a dormant account leaves it compressed; a truncated journal is refused without the
+// snapshot that covers it, && with an older one
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+
+#include "ATM.hpp"
+#include "AccountSnapshot.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    struct AccountState
+    {
+        int pin;
+        std::int64_t balanceCents;
+        std::vector<std::int64_t> amounts;
+
+        bool operator==(const AccountState &) const = default;
+    };
+
+    std::map<std::string, AccountState> capture(const ATM & atm)
+    {
+        std::map<std::string, AccountState> state;
+        atm.forEachAccount([&](std::string_view accountNumber, int pin, Money balance, std::span<const TransactionType>,
+                               std::span<const std::int64_t> amountColumn, std::span<const std::int64_t>, std::uint64_t)
+        {
+            state.emplace(std::string(accountNumber), AccountState{pin, balance.getCents(), {amountColumn.begin(), amountColumn.end()}});
+        });
+        return state;
+    }
+
+    void deposit(ATM & atm, const std::string & accountNumber, std::int64_t cents)
+    {
+        const Operation operation{TransactionType::Deposit, Money::fromCents(cents)};
+        atm.acquire(atm.tryAuthenticate(accountNumber, 1234))->applyBatch(std::span<const Operation>(&operation, 1));
+    }
+
+    std::size_t journalRecords(const std::string & path)
+    {
+        std::size_t records = 0;
+        WriteAheadLog::replay(path, [&](const WalRecord &) { ++records; });
+        return records;
+    }
+}
+
+int main()
+{
+    const std::string base = "/tmp/atm_checkpoint_test_" + std::to_string(::getpid());
+    const std::string journalPath = base + ".wal";
+    const std::string snapshotPath = base + ".snap";
+    const std::string fullSnapshotPath = base + ".full.snap";
+    ::unlink(journalPath.c_str());
+
+    std::map<std::string, AccountState> expected;
+    std::uint64_t lastLsn = 0;
+    {
+        ATM atm;
+        WriteAheadLog journal(journalPath, WalConfig{1, 1 << 20, std::chrono::microseconds(1)});
+        atm.attachJournal(journal);
+        for (int id = 0; id < 4; ++id)
+        {
+            atm.addAccount(std::to_string(9000 + id), 1234, Money::fromUnits(100));
+            deposit(atm, std::to_string(9000 + id), 100 + id);
+        }
+        check(atm.transfer(atm.tryAuthenticate("9000", 1234), atm.tryAuthenticate("9001", 1234), Money::fromCents(50)) == OperationResult::Applied, "transfer");
+
+        const AccountLease dormant = atm.acquire(atm.tryAuthenticate("9003", 1234));
+        check(atm.compressDormant(0) > 0 && dormant->isDormant(), "compressDormant");
+        check(AccountSnapshot::checkpoint(snapshotPath, atm), "checkpoint");
+        check(dormant->isDormant(), "the checkpoint expanded a dormant account");
+        check(journalRecords(journalPath) == 0, "the checkpoint left covered records in the journal");
+
+        // after the checkpoint: only these are left in the journal
+        deposit(atm, "9000", 7);
+        atm.addAccount("9100", 1234, Money::fromUnits(5));
+        deposit(atm, "9100", 9);
+        check(atm.transfer(atm.tryAuthenticate("9001", 1234), atm.tryAuthenticate("9100", 1234), Money::fromCents(25)) == OperationResult::Applied, "transfer after the checkpoint");
+        lastLsn = journal.lastLsn();
+        expected = capture(atm);
+    }
+    check(journalRecords(journalPath) == 5, "journal after the checkpoint");
+
+    {
+        const auto snapshot = AccountSnapshot::load(snapshotPath);
+        check(snapshot != nullptr && snapshot->coveredLsn() > 0, "checkpoint snapshot");
+        ATM atm;
+        atm.attachSnapshot(*snapshot);
+        check(atm.replayJournal(journalPath) == 5, "replay after the checkpoint");
+        check(capture(atm) == expected, "snapshot + journal differ from the state before the restart");
+
+        // sequence numbers continue where they stopped, also in a truncated journal
+        WriteAheadLog journal(journalPath);
+        check(journal.lastLsn() == lastLsn, "lsn after reopening a truncated journal");
+        atm.attachJournal(journal);
+        deposit(atm, "9002", 3);
+        check(journal.lastLsn() == lastLsn + 1, "lsn of a new record");
+        expected = capture(atm);
+    }
+
+    {
+        const auto snapshot = AccountSnapshot::load(snapshotPath);
+        ATM atm;
+        atm.attachSnapshot(*snapshot);
+        atm.replayJournal(journalPath);
+        check(capture(atm) == expected, "second restart");
+    }
+
+    {
+        // the records before the checkpoint are gone: no snapshot, || one from before the checkpoint
+        ATM bare;
+        check(!bare.isJournalCovered(journalPath), "a truncated journal counted as covered without a snapshot");
+        check(bare.replayJournal(journalPath) == 0 && bare.replayJournalParallel(journalPath, 2) == 0, "a truncated journal was replayed without a snapshot");
+        check(capture(bare).empty(), "accounts were rebuilt from a truncated journal");
+
+        const std::string staleSnapshotPath = base + ".stale.snap";
+        ATM empty;
+        check(AccountSnapshot::write(staleSnapshotPath, empty), "write an empty snapshot");
+        const auto stale = AccountSnapshot::load(staleSnapshotPath);
+        ATM behind;
+        behind.attachSnapshot(*stale);
+        check(!behind.isJournalCovered(journalPath) && behind.replayJournal(journalPath) == 0, "a snapshot older than the journal's base covered it");
+        ::unlink(staleSnapshotPath.c_str());
+
+        const auto snapshot = AccountSnapshot::load(snapshotPath);
+        ATM covered;
+        covered.attachSnapshot(*snapshot);
+        check(covered.isJournalCovered(journalPath), "the checkpoint snapshot doesn't cover its journal");
+    }
+
+    {
+        // the journal before the checkpoint is gone, but replaying it over a snapshot that includes
+        // part of it must not apply anything twice: rebuild it && compare
+        ::unlink(journalPath.c_str());
+        WriteAheadLog journal(journalPath, WalConfig{1, 1 << 20, std::chrono::microseconds(1)});
+        ATM atm;
+        atm.attachJournal(journal);
+        atm.addAccount("9200", 1234, Money::fromUnits(1));
+        deposit(atm, "9200", 11);
+        check(AccountSnapshot::write(fullSnapshotPath, atm), "write over a journal");
+        deposit(atm, "9200", 13);
+        expected = capture(atm);
+
+        const auto snapshot = AccountSnapshot::load(fullSnapshotPath);
+        ATM restored;
+        restored.attachSnapshot(*snapshot);
+        check(restored.replayJournal(journalPath) == 1, "records the snapshot includes were replayed");
+        check(capture(restored) == expected, "replay over a snapshot");
+    }
+
+    ::unlink(journalPath.c_str());
+    ::unlink(snapshotPath.c_str());
+    ::unlink(fullSnapshotPath.c_str());
+    std::printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
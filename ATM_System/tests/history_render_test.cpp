@@ -0,0 +1,64 @@
+// paged history output: a statement is written page by page, && a write error stops it at the
+// failing page instead of formatting the remaining pages for nobody
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <csignal>
+#include <unistd.h>
+
+#include "Account.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    std::uint64_t renderedPages()
+    {
+        return Metrics::summarize(MetricOp::RenderHistory).count;
+    }
+}
+
+int main()
+{
+    std::signal(SIGPIPE, SIG_IGN); // EPIPE instead
+
+    Account account("42", 1234, Money::fromUnits(10));
+    const std::vector<Operation> batch(2'500, Operation{TransactionType::Deposit, Money::fromCents(1)});
+    account.applyBatch(batch);
+    const std::size_t pageCount = (batch.size() + PageRequest{}.limit - 1) / PageRequest{}.limit;
+
+    // every page reaches the file
+    std::FILE * file = std::tmpfile();
+    std::uint64_t before = renderedPages();
+    check(account.showTransactionHistory(::fileno(file)), "statement to a file failed");
+    check(renderedPages() - before == pageCount, "not every page was rendered");
+    std::rewind(file);
+    std::size_t lines = 0;
+    for (int c = std::fgetc(file); c != EOF; c = std::fgetc(file))
+    {
+        lines += (c == '\n') ? 1 : 0;
+    }
+    check(lines == batch.size() + 1, "the statement lost lines");
+    std::fclose(file);
+
+    // a pipe nobody reads: the first page fails && is the last one rendered
+    int pipeFds[2];
+    check(::pipe(pipeFds) == 0, "pipe");
+    ::close(pipeFds[0]);
+    before = renderedPages();
+    check(!account.showTransactionHistory(pipeFds[1]), "a failed write was reported as a statement");
+    check(renderedPages() - before == 1, "pages were rendered after the write failed");
+    ::close(pipeFds[1]);
+
+    std::printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// operations whose journal write fails must leave no trace: a file size limit breaks the journal
+// part-way through, && the account's balance, history, snapshot && totals must then match
+// exactly the operations that were acknowledged
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <csignal>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "Account.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+}
+
+int main()
+{
+    const std::string path = "/tmp/atm_journal_rollback_test_" + std::to_string(::getpid()) + ".wal";
+    ::unlink(path.c_str());
+
+    std::signal(SIGXFSZ, SIG_IGN);
+    rlimit original{};
+    ::getrlimit(RLIMIT_FSIZE, &original);
+
+    const Money opening = Money::fromUnits(1'000);
+    Account account(std::string(100, '3'), 1234, opening);
+    Account peer(std::string(100, '4'), 4321, opening);
+    std::int64_t acknowledgedCents = opening.getCents();
+    std::size_t acknowledgedRows = 0;
+    std::size_t failedBatches = 0;
+    {
+        WriteAheadLog journal(path, WalConfig{1, 1 << 20, std::chrono::microseconds(1)});
+        account.attachJournal(&journal);
+        peer.attachJournal(&journal);
+        rlimit limited = original;
+        limited.rlim_cur = 4096;
+        check(::setrlimit(RLIMIT_FSIZE, &limited) == 0, "setrlimit");
+
+        // one snapshot from before the failure, it must not change when rows are rolled back
+        const Operation deposit{TransactionType::Deposit, Money::fromCents(500)};
+        account.applyBatch(std::span<const Operation>(&deposit, 1));
+        acknowledgedCents += 500;
+        ++acknowledgedRows;
+        const HistorySnapshot early = account.snapshot();
+
+        for (int i = 0; i < 40; ++i)
+        {
+            const Operation batch[] = {{TransactionType::Deposit, Money::fromCents(300)}, {TransactionType::Withdrawal, Money::fromCents(100)}};
+            const std::vector<OperationResult> results = account.applyBatch(batch);
+            if (results[0] == OperationResult::Applied)
+            {
+                acknowledgedCents += 200;
+                acknowledgedRows += 2;
+            }
+            else
+            {
+                check(results[0] == OperationResult::JournalFailure && results[1] == OperationResult::JournalFailure, "a failed batch must fail as a whole");
+                ++failedBatches;
+            }
+        }
+
+        // a settlement between two accounts after the failure: neither side may keep its half
+        NetPosition positions[] = {{&account, -700}, {&peer, 700}};
+        if (&peer < &account)
+        {
+            std::swap(positions[0], positions[1]);
+        }
+        check(Account::applyNetted(positions) == OperationResult::JournalFailure, "a settlement after the failure must fail");
+
+        check(early.size() == 1 && early[0].amount == Money::fromCents(500), "an earlier snapshot changed");
+    }
+    ::setrlimit(RLIMIT_FSIZE, &original);
+
+    check(failedBatches > 0, "the size limit never made a write fail");
+    check(account.getBalance().getCents() == acknowledgedCents, "a failed operation changed the balance");
+    check(peer.getBalance() == opening && peer.snapshot().empty(), "a failed settlement changed the other side");
+
+    const HistorySnapshot history = account.snapshot();
+    check(history.size() == acknowledgedRows, "a failed operation stayed in the history");
+    check(history.getBalance().getCents() == acknowledgedCents, "the history doesn't add up to the balance");
+    check(account.getTotal(TransactionType::Deposit).getCents() == 500 + 300 * static_cast<std::int64_t>(acknowledgedRows / 2), "deposit totals include failed operations");
+
+    ::unlink(path.c_str());
+    std::printf("%zu rows acknowledged, %zu batches rolled back, %s\n", acknowledgedRows, failedBatches, failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
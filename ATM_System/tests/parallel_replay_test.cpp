@@ -0,0 +1,126 @@
+// parallel replay read in small chunks: the same accounts as a sequential replay, also with a settlement
+// record bigger than a whole chunk, && both stop at the same record when the log is corrupt part-way
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <unistd.h>
+
+#include "ATM.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    struct AccountState
+    {
+        std::int64_t balanceCents;
+        std::vector<std::int64_t> amounts;
+
+        bool operator==(const AccountState &) const = default;
+    };
+
+    std::map<std::string, AccountState> capture(const ATM & atm)
+    {
+        std::map<std::string, AccountState> state;
+        atm.forEachAccount([&](std::string_view accountNumber, int, Money balance, std::span<const TransactionType>,
+                               std::span<const std::int64_t> amountColumn, std::span<const std::int64_t>, std::uint64_t)
+        {
+            state.emplace(std::string(accountNumber), AccountState{balance.getCents(), {amountColumn.begin(), amountColumn.end()}});
+        });
+        return state;
+    }
+
+    std::string number(int id)
+    {
+        // the longest number an account can have, so settlement legs are as large as they get
+        const std::string digits = std::to_string(id);
+        return std::string(ATM::maxAccountNumberLength - digits.size(), '0') + digits;
+    }
+
+    // accounts, sequential replay, parallel replay in tiny chunks && in one chunk
+    std::size_t compareReplays(const std::string & path, const char * what)
+    {
+        ATM sequential;
+        const std::size_t replayed = sequential.replayJournal(path);
+        const auto expected = capture(sequential);
+
+        ATM chunked;
+        check(chunked.replayJournalParallel(path, 4, 4096) == replayed, what);
+        check(capture(chunked) == expected, what);
+
+        ATM whole;
+        check(whole.replayJournalParallel(path, 3) == replayed, what);
+        check(capture(whole) == expected, what);
+        return replayed;
+    }
+}
+
+int main()
+{
+    const std::string path = "/tmp/atm_parallel_replay_test_" + std::to_string(::getpid()) + ".wal";
+    ::unlink(path.c_str());
+
+    constexpr int accountCount = 200;
+    std::size_t recordCount = 0;
+    {
+        ATM atm;
+        WriteAheadLog journal(path, WalConfig{64, 1 << 20, std::chrono::microseconds(50)});
+        atm.attachJournal(journal);
+        for (int id = 0; id < accountCount; ++id)
+        {
+            atm.addAccount(number(id), 1234, Money::fromUnits(1000));
+        }
+        for (int i = 0; i < 2'000; ++i)
+        {
+            const Operation batch[] = {{TransactionType::Deposit, Money::fromCents(100 + i)}, {TransactionType::Withdrawal, Money::fromCents(50)}};
+            atm.acquire(atm.tryAuthenticate(number(i % accountCount), 1234))->applyBatch(batch);
+            if (i % 7 == 0)
+            {
+                atm.transfer(atm.tryAuthenticate(number(i % accountCount), 1234), atm.tryAuthenticate(number((i * 13 + 1) % accountCount), 1234), Money::fromCents(i));
+            }
+        }
+
+        // one leg per account, every one a different net amount: a record of ~7 KiB
+        std::vector<Transfer> transfers;
+        for (int id = 0; id < accountCount; ++id)
+        {
+            transfers.push_back(Transfer{atm.tryAuthenticate(number(id), 1234), atm.tryAuthenticate(number((id + 1) % accountCount), 1234), Money::fromCents(id + 1)});
+        }
+        for (const OperationResult result : atm.settle(transfers))
+        {
+            check(result == OperationResult::Applied, "settle");
+        }
+        const Operation deposit{TransactionType::Deposit, Money::fromCents(5)};
+        atm.acquire(atm.tryAuthenticate(number(0), 1234))->applyBatch(std::span<const Operation>(&deposit, 1));
+        recordCount = static_cast<std::size_t>(journal.lastLsn());
+    }
+
+    check(compareReplays(path, "intact log") > 0, "nothing replayed");
+
+    // a flipped byte in the middle: everything from that record on is dropped by both
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    bytes[bytes.size() / 2] ^= 0x5a;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+    const std::size_t replayed = compareReplays(path, "corrupt log");
+    check(replayed > 0 && replayed < recordCount, "corrupt record not where expected");
+
+    ::unlink(path.c_str());
+    std::printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
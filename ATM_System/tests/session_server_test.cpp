@@ -0,0 +1,149 @@
+// SessionServer line protocol over a real socket: a session keeps working across requests,
+// && a line past maxLineLength (with or without its newline) is refused && the connection closed;
+// each DEPOSIT / WITHDRAW is timed under its own metric; a constructor that fails part-way
+// leaves no fd && no socket file behind
+#include <string>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "SessionServer.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    int connectTo(const std::string & path)
+    {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, path.c_str());
+        if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    std::size_t openFds()
+    {
+        std::size_t count = 0;
+        if (DIR * directory = ::opendir("/proc/self/fd"))
+        {
+            while (::readdir(directory) != nullptr)
+            {
+                ++count;
+            }
+            ::closedir(directory);
+        }
+        return count;
+    }
+
+    bool isConstructionRefused(ATM & atm, const std::string & path)
+    {
+        try
+        {
+            SessionServer server(atm, path);
+        }
+        catch (const std::system_error &)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    // one response line, or "" once the server has closed the connection
+    std::string request(int fd, const std::string & text)
+    {
+        if (!text.empty() && ::write(fd, text.data(), text.size()) != static_cast<ssize_t>(text.size()))
+        {
+            return "";
+        }
+        std::string response;
+        char byte;
+        while (::read(fd, &byte, 1) == 1)
+        {
+            response += byte;
+            if (byte == '\n')
+            {
+                break;
+            }
+        }
+        return response;
+    }
+}
+
+int main()
+{
+    const std::string path = "/tmp/atm_session_server_test_" + std::to_string(::getpid()) + ".sock";
+    std::signal(SIGPIPE, SIG_IGN); // the client side writes to connections the server has closed
+    ATM atm;
+    atm.addAccount("1001", 1234, Money::fromUnits(100));
+
+    {
+        const std::size_t fdsBefore = openFds();
+        check(isConstructionRefused(atm, "/nonexistent_atm_directory/atm.sock"), "bind into a missing directory");
+        check(openFds() == fdsBefore, "a failed bind leaked an fd");
+
+        // room for exactly one more fd: the socket binds, epoll_create1 fails
+        const int lowestFree = ::dup(0);
+        ::close(lowestFree);
+        rlimit original{};
+        ::getrlimit(RLIMIT_NOFILE, &original);
+        rlimit limited = original;
+        limited.rlim_cur = static_cast<rlim_t>(lowestFree + 1);
+        ::setrlimit(RLIMIT_NOFILE, &limited);
+        const bool isRefused = isConstructionRefused(atm, path);
+        ::setrlimit(RLIMIT_NOFILE, &original);
+        struct stat socketInfo{};
+        check(isRefused, "construction without a free fd");
+        check(openFds() == fdsBefore, "a failed epoll setup leaked an fd");
+        check(::stat(path.c_str(), &socketInfo) != 0, "a failed construction left its socket file");
+    }
+
+    SessionServer server(atm, path);
+    std::thread serverThread([&server] { server.run(); });
+
+    const int fd = connectTo(path);
+    check(fd >= 0, "connect");
+    check(request(fd, "LOGIN 1001 1234\n") == "OK\n", "login");
+    check(request(fd, "DEPOSIT 5.00\n") == "OK 105.00\n", "deposit");
+    check(request(fd, "WITHDRAW 10.00\n") == "OK 95.00\n", "withdraw");
+    check(Metrics::summarize(MetricOp::Deposite).count == 1 && Metrics::summarize(MetricOp::Withdraw).count == 1, "server operations timed as their own operation");
+    check(Metrics::summarize(MetricOp::ApplyBatch).count == 0, "server operations timed as batches");
+    check(request(fd, "BALANCE " + std::string(SessionServer::maxLineLength, 'x') + "\n") == "ERR line too long\n", "long line refused");
+    check(request(fd, "BALANCE\n").empty(), "connection closed after a long line");
+    ::close(fd);
+
+    // a line that never ends: the server stops buffering it && hangs up
+    const int endless = connectTo(path);
+    check(request(endless, "LOGIN 1001 1234\n") == "OK\n", "second login");
+    const std::string response = request(endless, std::string(2 * SessionServer::maxLineLength, 'y'));
+    check(response == "ERR line too long\n", "unterminated line refused");
+    ::close(endless);
+
+    server.stop();
+    serverThread.join();
+    check(atm.acquire(atm.tryAuthenticate("1001", 1234))->getBalance() == Money::fromUnits(95), "balance after the session");
+
+    std::printf("session server: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
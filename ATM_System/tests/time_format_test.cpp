@@ -0,0 +1,51 @@
+// formatTime: fixed-width local time, && timestamps whose year needs more than 4 digits (or is
+// negative) clamp to the first / last representable second instead of writing garbage digits
+#include <string>
+#include <string_view>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "Time.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    std::string formatted(std::int64_t epochSeconds)
+    {
+        char text[formattedTimeLength];
+        return std::string(text, formatTime(epochSeconds, text));
+    }
+}
+
+int main()
+{
+    ::setenv("TZ", "UTC", 1);
+    ::tzset();
+
+    constexpr std::int64_t yearTenThousand = 253'402'300'800; // 10000-01-01 00:00:00 UTC
+    constexpr std::int64_t yearZero = -62'167'219'200; // 0000-01-01 00:00:00 UTC
+
+    check(formatted(-1) == "1969-12-31 23:59:59", "the second before the epoch");
+    check(formatted(1'706'659'200) == "2024-01-31 00:00:00", "an ordinary timestamp");
+    check(formatted(yearTenThousand - 1) == "9999-12-31 23:59:59", "the last second of 9999");
+    check(formatted(yearTenThousand) == "9999-12-31 23:59:59", "year 10000 did not clamp");
+    check(formatted(std::numeric_limits<std::int64_t>::max()) == "9999-12-31 23:59:59", "INT64_MAX did not clamp");
+    check(formatted(yearZero) == "0000-01-01 00:00:00", "the first second of year 0");
+    check(formatted(yearZero - 1) == "0000-01-01 00:00:00", "year -1 did not clamp");
+    check(formatted(std::numeric_limits<std::int64_t>::min()) == "0000-01-01 00:00:00", "INT64_MIN did not clamp");
+
+    std::printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
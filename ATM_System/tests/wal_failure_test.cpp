@@ -0,0 +1,104 @@
+// write-ahead log I/O failure: a file size limit makes write() fail part-way through a batch, then is lifted;
+// the log must poison itself (no later lsn is ever reported durable) && replay must still
+// return exactly the records that were acknowledged; a log that can't be read is refused, not cut
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <cstdio>
+#include <csignal>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "WriteAheadLog.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char * what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+}
+
+int main()
+{
+    const std::string path = "/tmp/atm_wal_failure_test_" + std::to_string(::getpid()) + ".wal";
+    ::unlink(path.c_str());
+
+    // EFBIG instead of a fatal SIGXFSZ once the file would grow past the limit
+    std::signal(SIGXFSZ, SIG_IGN);
+    rlimit original{};
+    ::getrlimit(RLIMIT_FSIZE, &original);
+
+    const std::string accountNumber(100, '7'); // ~138 byte records, so the limit cuts one in half
+    std::size_t acknowledged = 0;
+    bool isFailed = false;
+    {
+        WriteAheadLog journal(path, WalConfig{1, 1 << 20, std::chrono::microseconds(1)});
+        rlimit limited = original;
+        limited.rlim_cur = 4096;
+        check(::setrlimit(RLIMIT_FSIZE, &limited) == 0, "setrlimit");
+
+        for (int i = 0; i < 100; ++i)
+        {
+            const std::uint64_t lsn = journal.append(WalRecordKind::Deposit, accountNumber, Money::fromCents(100 + i), 1'700'000'000 + i);
+            const bool isDurable = journal.waitDurable(lsn);
+            if (isDurable)
+            {
+                check(!isFailed, "an append after the first failure was reported durable");
+                ++acknowledged;
+            }
+            if (!isDurable && !isFailed)
+            {
+                // the disk "recovers": a log that kept writing would now report later records durable
+                // behind the torn one, which replay can never reach
+                ::setrlimit(RLIMIT_FSIZE, &original);
+            }
+            isFailed = isFailed || !isDurable;
+        }
+        check(isFailed, "the size limit never made a write fail");
+        check(acknowledged > 0, "nothing was written before the failure");
+    }
+    ::setrlimit(RLIMIT_FSIZE, &original);
+
+    std::size_t replayed = 0;
+    const std::size_t intactBytes = WriteAheadLog::replay(path, [&](const WalRecord & record)
+    {
+        check(record.amount == Money::fromCents(100 + static_cast<std::int64_t>(replayed)), "replayed records out of order");
+        ++replayed;
+    });
+    struct stat fileInfo{};
+    ::stat(path.c_str(), &fileInfo);
+    check(replayed == acknowledged, "replay doesn't return exactly the acknowledged records");
+    check(static_cast<std::size_t>(fileInfo.st_size) == intactBytes, "a torn batch was left at the end of the log");
+
+    ::unlink(path.c_str());
+
+    // pread fails (EISDIR) after the open succeeds: a read error, not a torn tail
+    const std::string directory = path + ".d";
+    check(::mkdir(directory.c_str(), 0755) == 0, "mkdir");
+    {
+        WalReader reader(directory);
+        WalContents chunk;
+        check(!reader.next(chunk) && reader.error() == EISDIR, "a failed read was reported as the end of the log");
+    }
+    try
+    {
+        WriteAheadLog journal(directory);
+        check(false, "a log that can't be read was opened");
+    }
+    catch (const std::system_error & error)
+    {
+        check(std::string_view(error.what()).find("cannot read") != std::string_view::npos, "the read error was not what refused the log");
+    }
+    ::rmdir(directory.c_str());
+
+    std::printf("%zu records acknowledged, %zu replayed, %s\n", acknowledged, replayed, failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}